@@ -0,0 +1,253 @@
+/*
+ * Microbenchmark timing the inner kernels of the coloring solver in
+ * isolation: graph_get_lowest_available_color(), used by DSATUR,
+ * calculate_proposed_solution_cost() and update_bad_edges(), used by every
+ * move of the annealer, and the proposal of a Kempe chain interchange.
+ *
+ * The solver module is included directly so the benchmark calls the same
+ * static kernels the solver runs.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/coloring_solver.c"
+
+/*
+ * Least time (in seconds) over which each kernel is measured.  The number of
+ * operations is doubled until a run takes at least this long.
+ */
+#define MIN_SECONDS 0.2
+
+/*
+ * Number of random moves drawn before timing, a power of two.  The kernels
+ * cycle through them, so drawing random numbers costs nothing in the timed
+ * loops, and the pool is too long for branch predictors to learn.
+ */
+#define MOVES 4096
+
+
+/*
+ * Signature of a benchmarked kernel: performs ops operations on the given
+ * context and returns the seconds elapsed.
+ */
+typedef double (*Kernel)(void *, long);
+
+/*
+ * Sink for results, so the compiler cannot discard the kernels' work.
+ */
+static volatile long sink;
+
+static double
+now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Times the given kernel and prints its cost per operation and throughput.
+ * @param const char *name
+ *      Name of the kernel.
+ * @param long size
+ *      Input size the context was built for.
+ */
+static void
+measure(const char *name, long size, Kernel run, void *ctx) {
+
+        double t;
+        long ops = 64;
+
+        run(ctx, ops);
+        while ((t = run(ctx, ops)) < MIN_SECONDS) ops *= 2;
+
+        printf("%-28s %8ld %12.2f ns/op %10.3f Mop/s\n", name, size,
+                        t * 1e9 / ops, ops / t / 1e6);
+}
+
+/*
+ * Context of the kernels: a random graph, a random coloring of it with
+ * k colors held both in the graph and in a solution S, and the neighbor
+ * color, color class and bad edge structures of the annealer for that
+ * coloring, and the moves the kernels are applied to.
+ */
+typedef struct {
+        Graph *g;
+        Node *S;
+        ColorScratch *scratch;
+        KempeChain kc;
+        int *A, *C, *E;
+        int k, cost;
+
+        /** Nodes moved and the colors, other than their own, they move to. */
+        int nodes[MOVES], colors[MOVES];
+} ColoringBench;
+
+/**
+ * Builds the context for a G(n, p) graph.
+ */
+static void
+coloring_bench_init(ColoringBench *b, int n, double p) {
+
+        int i, u, v;
+
+        b->g = graph_init(n);
+        for (u = 0; u < n; u++) {
+                for (v = 0; v < u; v++) {
+                        if ((double) rand() / RAND_MAX < p)
+                                graph_add_edge(b->g, u, v);
+                }
+        }
+        graph_finalize(b->g);
+
+        b->k = n / 10 > 1 ? n / 10 : 2;
+        for (u = 0; u < n; u++) graph_color_node(b->g, u, 1 + rand() % b->k);
+
+        b->scratch = color_scratch_init(n);
+        graph_copy_nodes(b->g, &b->S);
+        generate_neighbor_colors(b->g, b->S, b->k, &b->A);
+        generate_color_classes(b->S, &b->C, n);
+        generate_bad_edges(b->g, b->S, &b->E);
+        for (u = 0; u < n; u++) {
+                for (i = b->g->offsets[u]; i < b->g->offsets[u + 1]; i++) {
+                        v = b->g->neighbors[i];
+                        if (v < u && b->S[u].color == b->S[v].color)
+                                b->E[b->S[u].color]++;
+                }
+        }
+        b->cost = calculate_initial_solution_cost(b->S, b->C, b->E, n);
+        kempe_chain_init(&b->kc, n);
+
+        for (i = 0; i < MOVES; i++) {
+                u = b->nodes[i] = rand() % n;
+                do b->colors[i] = 1 + rand() % b->k;
+                while (b->colors[i] == b->S[u].color);
+        }
+}
+
+static void
+coloring_bench_free(ColoringBench *b) {
+
+        graph_free(b->g);
+        free(b->A);
+        color_scratch_free(b->scratch);
+        kempe_chain_free(&b->kc);
+        free(b->S);
+        free(b->C);
+        free(b->E);
+}
+
+static double
+run_lowest_color(void *x, long ops) {
+
+        ColoringBench *b = x;
+        double start = now();
+        long i, sum = 0;
+
+        for (i = 0; i < ops; i++)
+                sum += graph_get_lowest_available_color(b->g,
+                                &b->g->nodes[b->nodes[i & (MOVES - 1)]],
+                                b->scratch);
+
+        sink = sum;
+        return now() - start;
+}
+
+static double
+run_proposed_cost(void *x, long ops) {
+
+        ColoringBench *b = x;
+        double start = now();
+        long i, sum = 0;
+
+        for (i = 0; i < ops; i++)
+                sum += calculate_proposed_solution_cost(b->S, b->A, b->k,
+                                b->C, b->E, b->cost, b->nodes[i & (MOVES - 1)],
+                                b->colors[i & (MOVES - 1)]);
+
+        sink = sum;
+        return now() - start;
+}
+
+/**
+ * Moves a node to a new color and back, leaving the bad edge counts as they
+ * were.  One operation is one call of update_bad_edges().
+ */
+static double
+run_update_bad_edges(void *x, long ops) {
+
+        ColoringBench *b = x;
+        double start = now();
+        long i;
+        int u, c;
+
+        for (i = 0; i < ops; i += 2) {
+                u = b->nodes[i / 2 & (MOVES - 1)];
+                c = b->colors[i / 2 & (MOVES - 1)];
+                update_bad_edges(b->g, b->A, b->k, b->E, u, b->S[u].color,
+                                c);
+                update_bad_edges(b->g, b->A, b->k, b->E, u, c,
+                                b->S[u].color);
+        }
+
+        return now() - start;
+}
+
+/**
+ * Finds the Kempe chain of a random node and color and, unless it is too
+ * large, calculates the cost of its interchange.  One operation is one
+ * proposal, whether or not the chain was too large.
+ */
+static double
+run_kempe_chain(void *x, long ops) {
+
+        ColoringBench *b = x;
+        double start = now();
+        long i, sum = 0;
+        int u, c;
+
+        for (i = 0; i < ops; i++) {
+                u = b->nodes[i & (MOVES - 1)];
+                c = b->colors[i & (MOVES - 1)];
+                if (find_kempe_chain(b->g, b->S, &b->kc, u, c))
+                        sum += calculate_kempe_chain_cost(b->S, b->A, b->k,
+                                        b->C, b->E, b->cost, &b->kc);
+        }
+
+        sink = sum;
+        return now() - start;
+}
+
+int
+main(int argc, char **argv) {
+
+        int sizes[] = {100, 250, 500, 1000, 2000, 4000};
+        /* Accepted moves cost O(degree), so grow with the density. */
+        double densities[] = {0.05, 0.5};
+        ColoringBench b;
+        int i, j;
+
+        srand(1);
+
+        for (j = 0; j < 2; j++) {
+                printf("%-28s %8s %15s %16s   (density %.2f)\n", "kernel",
+                                "nodes", "cost", "throughput", densities[j]);
+
+                for (i = 0; i < (int) (sizeof(sizes) / sizeof(int)); i++) {
+                        coloring_bench_init(&b, sizes[i], densities[j]);
+                        measure("lowest_available_color", sizes[i],
+                                        run_lowest_color, &b);
+                        measure("proposed_solution_cost", sizes[i],
+                                        run_proposed_cost, &b);
+                        measure("update_bad_edges", sizes[i],
+                                        run_update_bad_edges, &b);
+                        measure("kempe_chain", sizes[i], run_kempe_chain,
+                                        &b);
+                        coloring_bench_free(&b);
+                }
+        }
+
+        return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * Module implementing a bucket queue of integer ids keyed by small integers.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bucket_queue.h"
+#include "utils.h"
+
+/**
+ * Initializes and returns an empty queue of the ids 0..n-1.
+ * @param int n
+ *      The number of ids.
+ * @param int nKeys
+ *      The number of keys expected, 0..nKeys-1.  Higher keys may be used,
+ *      growing the queue.
+ */
+BucketQueue *
+bucket_queue_init(int n, int nKeys) {
+
+        BucketQueue *q;
+        int i;
+
+        q = calloc(1, sizeof(BucketQueue));
+        if (!q) ALLOCATION_ERROR();
+
+        q->n = n;
+        q->nKeys = nKeys > 0 ? nKeys : 1;
+        q->top = -1;
+        q->heads = malloc(q->nKeys * sizeof(int));
+        q->next = malloc((n > 0 ? n : 1) * sizeof(int));
+        q->prev = malloc((n > 0 ? n : 1) * sizeof(int));
+        q->keys = malloc((n > 0 ? n : 1) * sizeof(int));
+        if (!q->heads || !q->next || !q->prev || !q->keys)
+                ALLOCATION_ERROR();
+
+        for (i = 0; i < q->nKeys; i++) q->heads[i] = -1;
+        for (i = 0; i < n; i++) q->keys[i] = -1;
+
+        return q;
+}
+
+/**
+ * Grows the queue to have a bucket for the given key.
+ */
+static void
+bucket_queue_grow(BucketQueue *q, int key) {
+
+        int i, nKeys = q->nKeys;
+
+        while (key >= nKeys) nKeys *= 2;
+
+        q->heads = realloc(q->heads, nKeys * sizeof(int));
+        if (!q->heads) ALLOCATION_ERROR();
+
+        for (i = q->nKeys; i < nKeys; i++) q->heads[i] = -1;
+        q->nKeys = nKeys;
+}
+
+/**
+ * Inserts id with the given key.  The id may not already be in the queue.
+ */
+void
+bucket_queue_push(BucketQueue *q, int id, int key) {
+
+        assert(key >= 0);
+        assert(q->keys[id] < 0);
+
+        if (key >= q->nKeys) bucket_queue_grow(q, key);
+
+        q->keys[id] = key;
+        q->prev[id] = -1;
+        q->next[id] = q->heads[key];
+        if (q->heads[key] >= 0) q->prev[q->heads[key]] = id;
+        q->heads[key] = id;
+
+        if (key > q->top) q->top = key;
+        q->nElements++;
+}
+
+/**
+ * Unlinks id from its bucket and marks it as not in the queue.
+ */
+static void
+bucket_queue_remove(BucketQueue *q, int id) {
+
+        if (q->prev[id] >= 0) q->next[q->prev[id]] = q->next[id];
+        else q->heads[q->keys[id]] = q->next[id];
+        if (q->next[id] >= 0) q->prev[q->next[id]] = q->prev[id];
+
+        q->keys[id] = -1;
+        q->nElements--;
+}
+
+/**
+ * Removes and returns an id with the highest key.  The queue may not be
+ * empty.
+ */
+int
+bucket_queue_pop(BucketQueue *q) {
+
+        int id;
+
+        assert(q->nElements > 0);
+
+        while (q->heads[q->top] < 0) q->top--;
+
+        id = q->heads[q->top];
+        bucket_queue_remove(q, id);
+
+        return id;
+}
+
+/**
+ * Moves id, which must be in the queue, to the given key.
+ */
+void
+bucket_queue_update(BucketQueue *q, int id, int key) {
+
+        if (q->keys[id] == key) return;
+
+        bucket_queue_remove(q, id);
+        bucket_queue_push(q, id, key);
+}
+
+int
+bucket_queue_contains(BucketQueue *q, int id) {
+        return q->keys[id] >= 0;
+}
+
+int
+bucket_queue_is_empty(BucketQueue *q) {
+        return q->nElements == 0;
+}
+
+void
+bucket_queue_free(BucketQueue *q) {
+        if (!q) return;
+        free(q->heads);
+        free(q->next);
+        free(q->prev);
+        free(q->keys);
+        free(q);
+}
@@ -0,0 +1,51 @@
+/*
+ * Module defining a bucket queue: a max priority queue of the integer ids
+ * 0..n-1 with small non-negative integer keys.  Each key has a bucket
+ * holding its ids in an intrusive doubly linked list, so an id is moved to
+ * a new key in O(1) and the highest key is found by stepping down from the
+ * highest key used.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef BUCKET_QUEUE_H
+#define BUCKET_QUEUE_H
+
+typedef struct {
+        /** First id in the bucket of each key, -1 if the bucket is empty. */
+        int *heads;
+
+        /** Number of buckets allocated (will grow). */
+        int nKeys;
+
+        /**
+         * Links of each id within its bucket, and its key, -1 if the id is
+         * not in the queue.
+         */
+        int *next;
+        int *prev;
+        int *keys;
+
+        /** Number of ids. */
+        int n;
+
+        /** Number of ids in the queue. */
+        int nElements;
+
+        /** No bucket above top holds an id. */
+        int top;
+} BucketQueue;
+
+BucketQueue *bucket_queue_init(int, int);
+
+void bucket_queue_push(BucketQueue *, int, int);
+
+int bucket_queue_pop(BucketQueue *);
+
+void bucket_queue_update(BucketQueue *, int, int);
+
+int bucket_queue_contains(BucketQueue *, int);
+
+int bucket_queue_is_empty(BucketQueue *);
+
+void bucket_queue_free(BucketQueue *);
+
+#endif
@@ -1,16 +1,21 @@
 /**     
- * Uses the DSATUR algorith and simulating annealing thereafter to produce a
- * solution to the coloring problem given an instance of a graph.
+ * Uses the DSATUR algorith and simulating annealing, Tabucol or replica
+ * exchange thereafter to produce a solution to the coloring problem given an
+ * instance of a graph.
  */
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
+#include "coloring_solver.h"
+#include "bucket_queue.h"
 #include "graph.h"
-#include "pqueue.h"
+#include "rng.h"
+#include "stats.h"
+#include "tabucol.h"
 #include "utils.h"
 
 /* Define simulation constants. */
@@ -18,10 +23,146 @@
 #define FREEZE_LIM 4
 #define INITIAL_TEMPERATURE 0.9
 #define TEMPFACTOR 0.95
-#define MINPERCENT 2
+#define MINPERCENT 0.02        /* Fraction of moves accepted below which
+                                   a temperature counts toward freezing. */
 #define SIZEFACTOR 16
 #define N 9.5
 #define CUTOFF 10
+#define MAX_TEMPERATURES 5000   /* Temperatures after which a chain stops
+                                   even if not frozen. */
+
+/* Define replica exchange constants. */
+#define PT_REPLICAS 8           /* Number of replicas (and threads). */
+#define PT_T_MIN 0.2            /* Temperature of the coldest replica. */
+#define PT_T_MAX 5.0            /* Temperature of the hottest replica. */
+
+/* Define Kempe chain constants. */
+#define KEMPE_MAX_NODES 32      /* Chains of more nodes than this are not
+                                   proposed. */
+
+/*
+ * A Kempe chain: the connected component containing a given node of the
+ * subgraph induced by the nodes colored a or b.  Exchanging a and b on the
+ * chain's nodes introduces no conflict, since no node outside the chain
+ * colored a or b is adjacent to it, so a valid coloring stays valid.
+ */
+typedef struct {
+        /** The two colors of the chain. */
+        int a, b;
+
+        /** The nodes of the chain, in the order they were found. */
+        int *nodes;
+        int size;
+
+        /** marks[v] == stamp iff node v is in the chain. */
+        unsigned *marks;
+        unsigned stamp;
+} KempeChain;
+
+/*
+ * State of one annealing chain.
+ */
+typedef struct {
+        /** The instance graph, holding the initial solution. */
+        Graph *g;
+
+        /** The number of colors the chain may use. */
+        int max_colors;
+
+        /** Fraction of the chain's moves which are Kempe chain
+         * interchanges. */
+        double kempe_rate;
+
+        /** The chain's own random number generator. */
+        Rng rng;
+
+        /** The best valid solution found by the chain, and its cost. */
+        Node *S_opt;
+        int c_opt;
+
+        /** Moves proposed and accepted by the chain. */
+        long moves_proposed;
+        long moves_accepted;
+
+        /** Kempe chain interchanges proposed and accepted by the chain. */
+        long kempe_proposed;
+        long kempe_accepted;
+} Chain;
+
+/*
+ * State of one replica of the replica exchange search: a solution at a
+ * temperature, with the structures of the annealer for it.
+ */
+typedef struct {
+        /** The instance graph, shared by all replicas. */
+        Graph *g;
+
+        /** The number of colors the replica may use. */
+        int max_colors;
+
+        /** Fraction of the replica's moves which are Kempe chain
+         * interchanges. */
+        double kempe_rate;
+
+        /** The solution and its color classes, bad edges and neighbour
+         * color counts, as in the annealer. */
+        Node *S;
+        int *C, *E, *A;
+
+        /** The cost of S, its number of bad edges and of colors used. */
+        int c;
+        int bad;
+        int used;
+
+        /** The temperature at which the replica currently runs. */
+        double T;
+
+        /** The best valid solution found: fewest colors, then least cost. */
+        Node *S_opt;
+        int c_opt;
+        int colors_opt;
+
+        /** The replica's own random number generator. */
+        Rng rng;
+
+        /** Moves proposed and accepted by the replica. */
+        long moves_proposed;
+        long moves_accepted;
+
+        /** Scratch space for the Kempe chains of the replica, and the
+         * interchanges proposed and accepted. */
+        KempeChain kempe;
+        long kempe_proposed;
+        long kempe_accepted;
+
+        /** The search the replica belongs to. */
+        struct Tempering *pt;
+} Replica;
+
+/*
+ * Shared state of the replica exchange search.
+ */
+typedef struct Tempering {
+        Replica *replicas;
+        int nReplicas;
+
+        /** order[t] is the replica at the t_th coldest temperature. */
+        int *order;
+        double *temperatures;
+
+        /** Replicas wait here between sweeps and exchanges. */
+        pthread_barrier_t barrier;
+
+        /** Time at which the search ends, and flag set once it has. */
+        double deadline;
+        int done;
+
+        /** Number of exchange rounds so far. */
+        long round;
+
+        /** Generator drawing the acceptance of exchanges. */
+        Rng rng;
+} Tempering;
 
 static void
 produce_initial_solution(Graph *);
@@ -30,7 +171,8 @@ static int
 calculate_initial_solution_cost(Node *, int *, int *, int);
 
 static int
-calculate_proposed_solution_cost(Graph *, Node *, int *, int *, int, int, int);
+calculate_proposed_solution_cost(Node *, int *, int, int *, int *, int, int,
+    int);
 
 static void
 copy_solution(Node *, Node *, int);
@@ -41,27 +183,53 @@ generate_color_classes(Node *, int **, int);
 static void
 generate_bad_edges(Graph *, Node *, int **);
 
+static void
+generate_neighbor_colors(Graph *, Node *, int, int **);
+
 static int
 is_valid_solution(int *, int);
 
 static void
-propose_new_solution(Graph *, Node *, int, int *, int *);
+propose_new_solution(Graph *, Node *, int, Rng *, int *, int *);
+
+static void
+update_color_classes(int *, int, int, int);
 
 static void
-update_pqueue_priorities(Graph *, PQueue *);
+update_bad_edges(Graph *, int *, int, int *, int, int, int);
 
 static void
-update_color_classes(int *, int, int, int);
+kempe_chain_init(KempeChain *, int);
 
 static void
-update_bad_edges(Graph *g, Node *, int *, int, int, int); 
+kempe_chain_free(KempeChain *);
 
-char *
-solve_coloring_instance(Graph *g) {
+static int
+find_kempe_chain(Graph *, Node *, KempeChain *, int, int);
 
+static int
+calculate_kempe_chain_cost(Node *, int *, int, int *, int *, int,
+    KempeChain *);
+
+static void
+apply_kempe_chain(Graph *, Node *, int *, int, int *, int *, KempeChain *);
+
+/**
+ * Runs one annealing chain from the initial solution held in the graph's
+ * nodes.  Chains share the graph, which they only read, and keep every
+ * other structure and their random number generator to themselves, so any
+ * number may run concurrently.
+ * @param void *x
+ *      Pointer to the Chain to run.
+ */
+static void *
+anneal(void *x) {
+
+        Chain *chain = x;
+        Graph *g = chain->g;
         Node *S, *S_opt;
+        KempeChain kc;
         double r, T, e;
-        char *sol_str;
         int *C;                         /* An array such that C[i] is the size
                                            of the i_th color class. */
         int *E;                         /* An array such that E[i] is the 
@@ -69,20 +237,16 @@ solve_coloring_instance(Graph *g) {
                                            color class (i.e., the number of 
                                            edges whose endpoints are colored
                                            the same color. */
+        int *A;                         /* An array such that
+                                           A[v * (max_colors + 1) + i] is the
+                                           number of neighbours of node v
+                                           colored i. */
         int c, c_proposed, c_opt, freeze_count = 0, n_trials = 0, changes = 0,
             proposed_color, proposed_node, old_color, delta, max_colors, i;
 
-        assert(g != NULL);
-
-        /* Seed randomon number generator. */
-        srand(time(NULL));
-
         /* Set initial temperature. */
         T = INITIAL_TEMPERATURE;
 
-        /* Produce initial solution using DSATUR algorithm. */
-        produce_initial_solution(g);        
-        
         /* Copy initial solution into S and S_opt. */
         graph_copy_nodes(g, &S);
         graph_copy_nodes(g, &S_opt);
@@ -90,35 +254,76 @@ solve_coloring_instance(Graph *g) {
         /* Init auxilliary structs. */
         generate_color_classes(S, &C, g->n);
         generate_bad_edges(g, S, &E);
-       
-        /* 
-         * Consider the colors used in the initial solution to be the
-         * max number of colors from which we can choose in our random
-         * solutions in the annealing process.
-         */
-        for (i = 1; i < g->n; i++) {
-                if (C[i] == 0) max_colors = i-1; 
-        }
 
+        max_colors = chain->max_colors;
+        generate_neighbor_colors(g, S, max_colors, &A);
 
         c = calculate_initial_solution_cost(S, C, E, g->n);
         c_opt = c;
 
+        kempe_chain_init(&kc, g->n);
+
         DEBUG_PRINT("Original cost: %d\n", c);
 
-        while (freeze_count < FREEZE_LIM) {
+        /* With a single color there is no move to propose. */
+        for (i = 0; max_colors > 1 && freeze_count < FREEZE_LIM &&
+            i < MAX_TEMPERATURES; i++) {
         
                 n_trials = 0;
                 changes = 0;
                 while (n_trials < 100 && changes < 80) {
 
                         n_trials++;
+
+                        if (chain->kempe_rate > 0 &&
+                            rng_uniform(&chain->rng) < chain->kempe_rate) {
+                                /* Exchange the colors of a node and of the
+                                 * proposed color along their chain. */
+                                propose_new_solution(g, S, max_colors,
+                                    &chain->rng, &proposed_node,
+                                    &proposed_color);
+                                if (!find_kempe_chain(g, S, &kc,
+                                    proposed_node, proposed_color))
+                                        continue;
+
+                                chain->kempe_proposed++;
+                                c_proposed = calculate_kempe_chain_cost(S, A,
+                                    max_colors, C, E, c, &kc);
+                                delta = c_proposed - c;
+
+                                if (delta > 0 && rng_uniform(&chain->rng) >
+                                    exp(-(double) delta / T))
+                                        continue;
+
+                                changes++;
+                                chain->kempe_accepted++;
+                                c = c_proposed;
+                                apply_kempe_chain(g, S, A, max_colors, C, E,
+                                    &kc);
+
+                                /*
+                                 * Interchanges of equal cost are common in
+                                 * a valid coloring, so only a strictly
+                                 * better one resets the freeze count.
+                                 */
+                                if (delta < 0 &&
+                                    is_valid_solution(E, max_colors) &&
+                                    c < c_opt) {
+                                        copy_solution(S, S_opt, g->n);
+                                        c_opt = c;
+                                        freeze_count = 0;
+                                }
+                                continue;
+                        }
+
+                        chain->moves_proposed++;
                         
-                        propose_new_solution(g, S, max_colors, &proposed_node, 
-                            &proposed_color);
+                        propose_new_solution(g, S, max_colors, &chain->rng,
+                            &proposed_node, &proposed_color);
                        
-                        c_proposed = calculate_proposed_solution_cost(g, S,
-                            C, E, c, proposed_node, proposed_color);
+                        c_proposed = calculate_proposed_solution_cost(S, A,
+                            max_colors, C, E, c, proposed_node,
+                            proposed_color);
 
 
                         delta = c_proposed - c;
@@ -126,16 +331,21 @@ solve_coloring_instance(Graph *g) {
                         if (delta <= 0) {
                                 /* New solution better than previous. */
                                 changes++;
+                                chain->moves_accepted++;
                                 c = c_proposed;
                                 old_color = S[proposed_node].color;
                                 update_color_classes(C, proposed_node, 
                                     old_color, proposed_color);                               
-                                update_bad_edges(g, S, E, proposed_node,
-                                    old_color, proposed_color);
+                                update_bad_edges(g, A, max_colors, E,
+                                    proposed_node, old_color, proposed_color);
                                 S[proposed_node].color = proposed_color; 
         
+                                /*
+                                 * As with interchanges, a move of equal cost
+                                 * does not reset the freeze count.
+                                 */
                                 if (is_valid_solution(E, max_colors) &&
-                                    c <= c_opt) {
+                                    c < c_opt) {
 
                                         /* Update optimal solution. */
                                 
@@ -147,16 +357,18 @@ DEBUG_PRINT("Proposed solution cost: %d\n Old solution cost: %d\n", c_proposed,
                                 }
                         } else {
 
-                                r = (double) rand() / (double) RAND_MAX;
+                                r = rng_uniform(&chain->rng);
                                 e = exp(-((double)c_proposed - (double)c) / T);               
                                 if (r <= e) {
                                         changes++;
+                                        chain->moves_accepted++;
                                         c = c_proposed;
                                         old_color = S[proposed_node].color;
                                         update_color_classes(C, proposed_node,
                                             old_color, proposed_color);
-                                        update_bad_edges(g, S, E, proposed_node,
-                                            old_color, proposed_color);
+                                        update_bad_edges(g, A, max_colors, E,
+                                            proposed_node, old_color,
+                                            proposed_color);
                                         S[proposed_node].color = proposed_color;
                                 }
                         }
@@ -168,17 +380,551 @@ DEBUG_PRINT("Proposed solution cost: %d\n Old solution cost: %d\n", c_proposed,
                 }
         }
 
+        chain->S_opt = S_opt;
+        chain->c_opt = c_opt;
+
+        kempe_chain_free(&kc);
+        free(S);
+        free(C);
+        free(E);
+        free(A);
+
+        return NULL;
+}
+
+/**
+ * Produces a solution to the coloring problem by coloring the graph with
+ * DSATUR and then improving the coloring with independent annealing chains,
+ * keeping the best solution found by any chain.
+ * @param Graph *g
+ *      Pointer to the graph specifying the instance of the problem to be
+ *      solved.
+ * @param int threads
+ *      The number of chains, each run on its own thread.
+ * @param double kempe
+ *      Fraction of the moves which are Kempe chain interchanges rather than
+ *      the recoloring of a single node.
+ * @param unsigned long seed
+ *      Seed of the random number generators.  Chain i draws from stream i
+ *      of the seed, so the solution depends only on the seed and the
+ *      number of chains.
+ */
+char *
+solve_coloring_instance(Graph *g, int threads, double kempe,
+    unsigned long seed) {
+
+        Chain *chains, *best;
+        pthread_t *ids;
+        int *started, i;
+
+        assert(g != NULL);
+        assert(threads >= 1);
+
+        /* Produce initial solution using DSATUR algorithm. */
+        stats_phase_begin(PHASE_INITIAL);
+        produce_initial_solution(g);        
+        stats_phase_end(PHASE_INITIAL);
+
+        /* 
+         * Consider the colors used in the initial solution to be the
+         * max number of colors from which we can choose in our random
+         * solutions in the annealing process.
+         */
+        for (i = 0; i < g->n; i++) {
+                if (g->nodes[i].color > stats.initial_colors)
+                        stats.initial_colors = g->nodes[i].color;
+        }
+
+        chains = calloc(threads, sizeof(Chain));
+        ids = malloc(threads * sizeof(pthread_t));
+        started = calloc(threads, sizeof(int));
+        if (!chains || !ids || !started) ALLOCATION_ERROR();
+
+        for (i = 0; i < threads; i++) {
+                chains[i].g = g;
+                chains[i].max_colors = stats.initial_colors;
+                chains[i].kempe_rate = kempe;
+                rng_seed(&chains[i].rng, seed, i);
+        }
+
+        stats_phase_begin(PHASE_SEARCH);
+
+        /* Chain 0 runs on this thread, and any chain whose thread could not
+         * be created runs here after it. */
+        for (i = 1; i < threads; i++) {
+                started[i] = pthread_create(&ids[i], NULL, anneal,
+                                &chains[i]) == 0;
+        }
+        anneal(&chains[0]);
+        for (i = 1; i < threads; i++) {
+                if (started[i]) pthread_join(ids[i], NULL);
+                else anneal(&chains[i]);
+        }
+
+        stats_phase_end(PHASE_SEARCH);
+
+        /* Keep the best solution, the first chain's on ties. */
+        best = &chains[0];
+        for (i = 0; i < threads; i++) {
+                stats.moves_proposed += chains[i].moves_proposed;
+                stats.moves_accepted += chains[i].moves_accepted;
+                stats.kempe_proposed += chains[i].kempe_proposed;
+                stats.kempe_accepted += chains[i].kempe_accepted;
+                if (chains[i].c_opt < best->c_opt) best = &chains[i];
+        }
+
+        for (i = 0; i < g->n; i++) graph_color_node(g, i, best->S_opt[i].color);
+
 #ifdef DEBUG
         fprintf(stdout, "----------------------------------------------=---\n");
-        fprintf(stdout, "COST: %d\n", c_opt);
+        fprintf(stdout, "COST: %d\n", best->c_opt);
+        fprintf(stdout, "----------------------------------------------=---\n");
+#endif
+
+        for (i = 0; i < threads; i++) free(chains[i].S_opt);
+        free(chains);
+        free(ids);
+        free(started);
+
+        return coloring_solution_string(g, 0);
+}
+
+/**
+ * Removes the smallest color class of a coloring with colors 1..k: its nodes
+ * are left uncolored (color 0) and the nodes of color k take its color, so
+ * the coloring uses colors 1..k-1 on the remaining nodes.
+ */
+static void
+remove_color_class(int *colors, int n, int k) {
+
+        int *sizes, i, smallest = 1;
+
+        sizes = calloc(k + 1, sizeof(int));
+        if (!sizes) ALLOCATION_ERROR();
+
+        for (i = 0; i < n; i++) sizes[colors[i]]++;
+        for (i = 2; i <= k; i++) {
+                if (sizes[i] < sizes[smallest]) smallest = i;
+        }
+
+        for (i = 0; i < n; i++) {
+                if (colors[i] == smallest) colors[i] = 0;
+                else if (colors[i] == k) colors[i] = smallest;
+        }
+
+        free(sizes);
+}
+
+/**
+ * Produces a solution to the coloring problem by coloring the graph with
+ * DSATUR and then reducing the number of colors one at a time: after each
+ * valid coloring with k colors, the smallest color class is removed, Tabucol
+ * redistributes its nodes and searches for a valid coloring with k-1
+ * colors, until a search fails or the time budget runs out.
+ * @param Graph *g
+ *      Pointer to the graph specifying the instance of the problem to be
+ *      solved.
+ * @param int target
+ *      The number of colors at which to stop, 0 to continue as long as
+ *      colorings are found.
+ * @param double seconds
+ *      Wall time for which the searches may run.
+ * @param unsigned long seed
+ *      Seed of the random number generator.
+ * @return
+ *      The best coloring found, encoded by coloring_solution_string().
+ */
+char *
+solve_coloring_instance_tabucol(Graph *g, int target, double seconds,
+    unsigned long seed) {
+
+        Rng rng;
+        double deadline;
+        int *colors, k, i;
+
+        assert(g != NULL);
+
+        rng_seed(&rng, seed, 0);
+
+        stats_phase_begin(PHASE_INITIAL);
+        produce_initial_solution(g);
+        stats_phase_end(PHASE_INITIAL);
+
+        colors = malloc(g->n * sizeof(int));
+        if (!colors) ALLOCATION_ERROR();
+
         for (i = 0; i < g->n; i++) {
-                //fprintf(stdout, "%d->color = %d\n", i, S_opt[i].color);
+                if (g->nodes[i].color > stats.initial_colors)
+                        stats.initial_colors = g->nodes[i].color;
         }
-        fprintf(stdout, "----------------------------------------------=---\n");
+
+        stats_phase_begin(PHASE_SEARCH);
+        deadline = stats_now() + seconds;
+
+        /* The graph's nodes hold the best coloring, with k colors. */
+        for (k = stats.initial_colors; k > 1 && k > target; k--) {
+
+                for (i = 0; i < g->n; i++) colors[i] = g->nodes[i].color;
+                remove_color_class(colors, g->n, k);
+
+                if (tabucol(g, colors, k - 1, TABUCOL_MAX_ITERATIONS,
+                    deadline, &rng) != 0)
+                        break;
+
+                for (i = 0; i < g->n; i++) graph_color_node(g, i, colors[i]);
+                DEBUG_PRINT("Found a coloring with %d colors", k - 1);
+        }
+
+        stats_phase_end(PHASE_SEARCH);
+
+#ifdef DEBUG
+        graph_is_valid_coloring(g, 1);
 #endif
+
+        free(colors);
+        return coloring_solution_string(g, 0);
+}
+
+/**
+ * Records the replica's solution if it is the best valid one the replica
+ * has seen: fewest colors, then least cost.
+ */
+static void
+replica_record(Replica *r) {
+
+        if (r->bad == 0 && (r->used < r->colors_opt ||
+            (r->used == r->colors_opt && r->c < r->c_opt))) {
+                copy_solution(r->S, r->S_opt, r->g->n);
+                r->c_opt = r->c;
+                r->colors_opt = r->used;
+        }
+}
+
+/**
+ * Proposes to the replica the Kempe chain interchange of a random node and
+ * color, and makes it according to the Metropolis criterion at the
+ * replica's temperature.  The interchange leaves the number of bad edges
+ * unchanged; only the classes of the chain's two colors may empty or fill.
+ */
+static void
+replica_kempe_step(Replica *r) {
+
+        Graph *g = r->g;
+        KempeChain *kc = &r->kempe;
+        int u, color, c_proposed;
+
+        propose_new_solution(g, r->S, r->max_colors, &r->rng, &u, &color);
+        if (!find_kempe_chain(g, r->S, kc, u, color)) return;
+
+        c_proposed = calculate_kempe_chain_cost(r->S, r->A, r->max_colors,
+                        r->C, r->E, r->c, kc);
+        r->kempe_proposed++;
+
+        if (c_proposed > r->c &&
+            rng_uniform(&r->rng) > exp(-(c_proposed - r->c) / r->T))
+                return;
+
+        r->used -= (r->C[kc->a] > 0) + (r->C[kc->b] > 0);
+        apply_kempe_chain(g, r->S, r->A, r->max_colors, r->C, r->E, kc);
+        r->used += (r->C[kc->a] > 0) + (r->C[kc->b] > 0);
+        r->c = c_proposed;
+        r->kempe_accepted++;
+
+        replica_record(r);
+}
+
+/**
+ * Proposes one move to the replica, a Kempe chain interchange with
+ * probability kempe_rate and otherwise the recoloring of a single node,
+ * and makes it according to the Metropolis criterion at the replica's
+ * temperature, recording the solution if it is the best valid one the
+ * replica has seen.
+ */
+static void
+replica_step(Replica *r) {
+
+        Graph *g = r->g;
+        size_t row;
+        int u, color, old_color, c_proposed;
+
+        if (r->kempe_rate > 0 && rng_uniform(&r->rng) < r->kempe_rate) {
+                replica_kempe_step(r);
+                return;
+        }
+
+        propose_new_solution(g, r->S, r->max_colors, &r->rng, &u, &color);
+        c_proposed = calculate_proposed_solution_cost(r->S, r->A,
+                        r->max_colors, r->C, r->E, r->c, u, color);
+        r->moves_proposed++;
+
+        if (c_proposed > r->c &&
+            rng_uniform(&r->rng) > exp(-(c_proposed - r->c) / r->T))
+                return;
+
+        old_color = r->S[u].color;
+        row = (size_t) u * (r->max_colors + 1);
+        r->bad += r->A[row + color] - r->A[row + old_color];
+        r->used += (r->C[color] == 0) - (r->C[old_color] == 1);
+
+        update_color_classes(r->C, u, old_color, color);
+        update_bad_edges(g, r->A, r->max_colors, r->E, u, old_color, color);
+        r->S[u].color = color;
+        r->c = c_proposed;
+        r->moves_accepted++;
+
+        replica_record(r);
+}
+
+/**
+ * Attempts to exchange the temperatures of the replicas at adjacent
+ * temperatures, pairing even slots with the next one on even rounds and odd
+ * slots on odd rounds.  An exchange between the replicas i and j at
+ * temperatures T_i < T_j is accepted with probability
+ * min(1, exp((1/T_i - 1/T_j) * (c_i - c_j))), which keeps each replica's
+ * distribution that of its temperature.
+ */
+static void
+tempering_exchange(Tempering *pt) {
+
+        Replica *a, *b;
+        double x;
+        int t, tmp;
+
+        for (t = pt->round % 2; t + 1 < pt->nReplicas; t += 2) {
+                a = &pt->replicas[pt->order[t]];
+                b = &pt->replicas[pt->order[t + 1]];
+                x = (1.0 / a->T - 1.0 / b->T) * (a->c - b->c);
+                stats.swaps_proposed++;
+
+                if (x >= 0 || rng_uniform(&pt->rng) < exp(x)) {
+                        tmp = pt->order[t];
+                        pt->order[t] = pt->order[t + 1];
+                        pt->order[t + 1] = tmp;
+                        a->T = pt->temperatures[t + 1];
+                        b->T = pt->temperatures[t];
+                        stats.swaps_accepted++;
+                }
+        }
+        pt->round++;
+}
+
+/**
+ * Runs one replica: a sweep of n moves at its temperature, then a wait for
+ * every replica to finish its sweep while the first replica's thread makes
+ * the exchanges, until the time budget runs out.
+ * @param void *x
+ *      Pointer to the Replica to run.
+ */
+static void *
+tempering_run(void *x) {
+
+        Replica *r = x;
+        Tempering *pt = r->pt;
+        int i;
+
+        while (!pt->done) {
+                for (i = 0; i < r->g->n; i++) replica_step(r);
+
+                pthread_barrier_wait(&pt->barrier);
+                if (r == &pt->replicas[0]) {
+                        tempering_exchange(pt);
+                        if (stats_now() >= pt->deadline) pt->done = 1;
+                }
+                pthread_barrier_wait(&pt->barrier);
+        }
+
         return NULL;
 }
 
+/**
+ * Produces a solution to the coloring problem by coloring the graph with
+ * DSATUR and then running replica exchange (parallel tempering): PT_REPLICAS
+ * annealer chains at fixed temperatures spaced geometrically between
+ * PT_T_MIN and PT_T_MAX, each on its own thread, which periodically attempt
+ * to exchange temperatures with the chain at the adjacent temperature.  Hot
+ * chains move between distant colorings, cold ones refine them, and good
+ * colorings travel down the ladder.  The valid solution with the fewest
+ * colors found by any chain is kept.
+ * @param Graph *g
+ *      Pointer to the graph specifying the instance of the problem to be
+ *      solved.
+ * @param double seconds
+ *      Wall time for which the chains run.
+ * @param double kempe
+ *      Fraction of the moves which are Kempe chain interchanges rather than
+ *      the recoloring of a single node.
+ * @param unsigned long seed
+ *      Seed of the random number generators.  Replica i draws from stream
+ *      i + 1 of the seed and the exchanges from stream 0.
+ */
+char *
+solve_coloring_instance_tempering(Graph *g, double seconds, double kempe,
+    unsigned long seed) {
+
+        Tempering pt;
+        Replica *r, *best;
+        pthread_t ids[PT_REPLICAS];
+        int i, t;
+
+        assert(g != NULL);
+
+        stats_phase_begin(PHASE_INITIAL);
+        produce_initial_solution(g);
+        stats_phase_end(PHASE_INITIAL);
+
+        for (i = 0; i < g->n; i++) {
+                if (g->nodes[i].color > stats.initial_colors)
+                        stats.initial_colors = g->nodes[i].color;
+        }
+
+        memset(&pt, 0, sizeof(Tempering));
+        pt.nReplicas = PT_REPLICAS;
+        pt.replicas = calloc(PT_REPLICAS, sizeof(Replica));
+        pt.order = malloc(PT_REPLICAS * sizeof(int));
+        pt.temperatures = malloc(PT_REPLICAS * sizeof(double));
+        if (!pt.replicas || !pt.order || !pt.temperatures) ALLOCATION_ERROR();
+        rng_seed(&pt.rng, seed, 0);
+        pthread_barrier_init(&pt.barrier, NULL, PT_REPLICAS);
+
+        for (t = 0; t < PT_REPLICAS; t++) {
+                r = &pt.replicas[t];
+                pt.order[t] = t;
+                pt.temperatures[t] = PT_T_MIN * pow(PT_T_MAX / PT_T_MIN,
+                                (double) t / (PT_REPLICAS - 1));
+
+                r->g = g;
+                r->pt = &pt;
+                r->T = pt.temperatures[t];
+                r->max_colors = stats.initial_colors;
+                r->kempe_rate = kempe;
+                rng_seed(&r->rng, seed, t + 1);
+
+                graph_copy_nodes(g, &r->S);
+                graph_copy_nodes(g, &r->S_opt);
+                generate_color_classes(r->S, &r->C, g->n);
+                generate_bad_edges(g, r->S, &r->E);
+                generate_neighbor_colors(g, r->S, r->max_colors, &r->A);
+                kempe_chain_init(&r->kempe, g->n);
+                r->c = r->c_opt = calculate_initial_solution_cost(r->S, r->C,
+                                r->E, g->n);
+                r->colors_opt = r->used = stats.initial_colors;
+        }
+
+        stats_phase_begin(PHASE_SEARCH);
+        pt.deadline = stats_now() + seconds;
+
+        /*
+         * Every replica needs its own thread, as they wait for each other
+         * between sweeps.  With a single color there is no move to propose.
+         */
+        for (i = 1; i < PT_REPLICAS && stats.initial_colors > 1; i++) {
+                if (pthread_create(&ids[i], NULL, tempering_run,
+                    &pt.replicas[i]) != 0) {
+                        fprintf(stderr, "Failed to create thread for "
+                                        "replica %d.\n", i);
+                        exit(1);
+                }
+        }
+        if (stats.initial_colors > 1) {
+                tempering_run(&pt.replicas[0]);
+                for (i = 1; i < PT_REPLICAS; i++) pthread_join(ids[i], NULL);
+        }
+
+        stats_phase_end(PHASE_SEARCH);
+
+        best = &pt.replicas[0];
+        for (i = 0; i < PT_REPLICAS; i++) {
+                r = &pt.replicas[i];
+                stats.moves_proposed += r->moves_proposed;
+                stats.moves_accepted += r->moves_accepted;
+                stats.kempe_proposed += r->kempe_proposed;
+                stats.kempe_accepted += r->kempe_accepted;
+                if (r->colors_opt < best->colors_opt ||
+                    (r->colors_opt == best->colors_opt &&
+                     r->c_opt < best->c_opt))
+                        best = r;
+        }
+
+        /* The best solution may leave some of colors 1..k unused. */
+        for (i = 0; i < g->n; i++) graph_color_node(g, i, best->S_opt[i].color);
+
+#ifdef DEBUG
+        graph_is_valid_coloring(g, 1);
+#endif
+
+        for (i = 0; i < PT_REPLICAS; i++) {
+                r = &pt.replicas[i];
+                free(r->S);
+                free(r->S_opt);
+                free(r->C);
+                free(r->E);
+                free(r->A);
+                kempe_chain_free(&r->kempe);
+        }
+        pthread_barrier_destroy(&pt.barrier);
+        free(pt.replicas);
+        free(pt.order);
+        free(pt.temperatures);
+
+        return coloring_solution_string(g, 0);
+}
+
+/**
+ * Encodes the coloring held by the graph's nodes in the expected output
+ * format.  The first line contains the number of colors used and whether
+ * the coloring is known to be optimal, the second line the color of each
+ * node.  Colors are renumbered 0..k-1 in increasing order, so a coloring
+ * which leaves some colors unused is written with k colors.
+ * @param Graph *g
+ *      Pointer to the graph whose nodes hold the coloring.
+ * @param int optimal
+ *      1 if the coloring is known to be optimal, 0 otherwise.
+ *
+ * @return
+ *      Pointer to the solution string.
+ */
+char *
+coloring_solution_string(Graph *g, int optimal) {
+
+        char *sol;
+        int *labels, max_color = 0, k = 0, len, i;
+
+        for (i = 0; i < g->n; i++) {
+                if (g->nodes[i].color > max_color)
+                        max_color = g->nodes[i].color;
+        }
+
+        labels = calloc(max_color + 1, sizeof(int));
+        if (!labels) ALLOCATION_ERROR();
+
+        for (i = 0; i < g->n; i++) labels[g->nodes[i].color] = 1;
+        for (i = 0; i <= max_color; i++) {
+                if (labels[i]) labels[i] = k++;
+        }
+
+        /*
+         * For the first line, need 2 integers of at most 11 digits and 2
+         * bytes of whitespace; for the second, 1 integer of at most 11
+         * digits and 1 byte of whitespace per node.
+         */
+        len = 11 + 1 + 1 + 1 + 12 * g->n + 1;
+
+        sol = malloc((len + 1) * sizeof(char));
+        if (!sol) ALLOCATION_ERROR();
+
+        len = sprintf(sol, "%d %d\n", k, optimal);
+
+        stats.colors = k;
+
+        for (i = 0; i < g->n; i++)
+                len += sprintf(sol + len, "%d ", labels[g->nodes[i].color]);
+        sol[len++] = '\n';
+        sol[len] = '\0';
+
+        free(labels);
+        return sol;
+}
+
 /**
  * Calculate the cost of the initial solution to the coloring problem.
  * The "cost"/"target" function is given by the following expression:
@@ -216,6 +962,10 @@ calculate_initial_solution_cost(Node *S, int *C, int *E, int n) {
  *      Pointer to problem graph instance.
  * @param Node *S
  *      The old solution we are improving upon.
+ * @param int *A
+ *      Neighbour color counts of S.
+ * @param int k
+ *      The number of colors counted in A.
  * @param int *C
  *      Color classes data structure.
  * @param int *E
@@ -229,10 +979,10 @@ calculate_initial_solution_cost(Node *S, int *C, int *E, int n) {
  *      The new color we are proposing to change the node 'u' to.
  */
 static int
-calculate_proposed_solution_cost(Graph *g, Node *S, int *C, int *E, 
+calculate_proposed_solution_cost(Node *S, int *A, int k, int *C, int *E,
     int neighbour_cost, int u, int new_color) {
         
-        int i = 0, cost = 0, neighbour_color, C_new_color, E_new_color,
+        int cost = 0, neighbour_color, C_new_color, E_new_color,
             C_neighbour_color, E_neighbour_color, n_conflicts_resolved = 0,
             n_conflicts_introduced = 0;
 
@@ -265,16 +1015,8 @@ calculate_proposed_solution_cost(Graph *g, Node *S, int *C, int *E,
          * of bad edges in color class neighbour_color and increase the number
          * of bad edges in color class new_color.
          */
-        for (i = 0; i < g->n; i++) {
-
-                if (g->adj[u][i] == 1 && i != u) {
-                        if (S[i].color == neighbour_color) {
-                                n_conflicts_resolved++;
-                        } else if (S[i].color == new_color) {
-                                n_conflicts_introduced++;
-                        }
-                }
-        }
+        n_conflicts_resolved = A[(size_t) u * (k + 1) + neighbour_color];
+        n_conflicts_introduced = A[(size_t) u * (k + 1) + new_color];
 
         E_new_color = E[new_color] + n_conflicts_introduced;
         E_neighbour_color = E[neighbour_color] - n_conflicts_resolved;
@@ -314,6 +1056,39 @@ generate_bad_edges(Graph *g, Node *S, int **E) {
          * for all i |E_i| = 0 */
 }
 
+/**
+ * Initialize the neighbour color counts of a solution: an n * (k + 1) table
+ * whose entry (v, i) is the number of neighbours of node v colored i, so the
+ * conflicts a move would resolve or introduce are looked up in O(1).
+ * @param Graph *g
+ *      The instance graph for the coloring problem.
+ * @param Node *S
+ *      The solution, colored with colors 1 to k.
+ * @param int k
+ *      The highest color used in S or by any proposed move.
+ * @param int **A
+ *      Pointer to array of integers used to store the table.
+ */
+static void
+generate_neighbor_colors(Graph *g, Node *S, int k, int **A) {
+
+        int u, i;
+
+        assert(g != NULL);
+        assert(S != NULL);
+        assert(A != NULL);
+
+        *A = calloc((size_t) g->n * (k + 1), sizeof(int));
+        if (!*A) ALLOCATION_ERROR();
+
+        for (u = 0; u < g->n; u++) {
+                for (i = g->offsets[u]; i < g->offsets[u + 1]; i++) {
+                        (*A)[(size_t) u * (k + 1) +
+                                S[g->neighbors[i]].color]++;
+                }
+        }
+}
+
 /**
  * Initialize the structure containing the sizes of each color class.
  * @param Node *S
@@ -366,13 +1141,13 @@ is_valid_solution(int *E, int max_colors) {
  * Proposee a new solution which is a neighbour of the current solution.
  */
 static void
-propose_new_solution(Graph *g, Node *S, int max_colors, int *proposed_node, 
-    int *proposed_color) {
+propose_new_solution(Graph *g, Node *S, int max_colors, Rng *rng,
+    int *proposed_node, int *proposed_color) {
 
         int isValid = 0;
         while (!isValid) {
-                *proposed_node = rand() % g->n;
-                *proposed_color = (rand() % max_colors) + 1;
+                *proposed_node = rng_below(rng, g->n);
+                *proposed_color = rng_below(rng, max_colors) + 1;
 
                 if (S[*proposed_node].color != *proposed_color) {
                         isValid = 1;
@@ -400,13 +1175,15 @@ update_color_classes(int *C, int u, int old_color, int new_color) {
 }
 
 /**
- * Update the bad edges data structure.
- * NOTE: relies on the old solution's array of nodes to make proper updates.
+ * Update the bad edges and neighbour color count data structures.
  * @param Graph *g
  *      The instance graph for the coloring problem.
- * @param Node *S
- *      The old solution (i.e., the one that is being replaced that prompted
- *      the update)
+ * @param int *A
+ *      Neighbour color counts of the old solution (i.e., the one that is
+ *      being replaced that prompted the update).  Updated to the new
+ *      solution.
+ * @param int k
+ *      The number of colors counted in A.
  * @param int *E
  *      The bad edges data structure.
  * @param int u
@@ -418,25 +1195,182 @@ update_color_classes(int *C, int u, int old_color, int new_color) {
  *      The new color for the node 'u'
  */
 static void
-update_bad_edges(Graph *g, Node *S, int *E, int u, int old_color, int new_color) {
+update_bad_edges(Graph *g, int *A, int k, int *E, int u, int old_color,
+    int new_color) {
 
-        int i;
-        for (i = 0; i < g->n; i++) {
-        
-                if (g->adj[u][i] == 1 && u != i) {
+        int i, *a;
+
+        E[old_color] -= A[(size_t) u * (k + 1) + old_color];
+        E[new_color] += A[(size_t) u * (k + 1) + new_color];
+
+        for (i = g->offsets[u]; i < g->offsets[u + 1]; i++) {
+                a = &A[(size_t) g->neighbors[i] * (k + 1)];
+                a[old_color]--;
+                a[new_color]++;
+        }
+}
+
+/**
+ * Allocates the scratch space of Kempe chains in a graph of n nodes.
+ */
+static void
+kempe_chain_init(KempeChain *kc, int n) {
 
-                        if (S[i].color == old_color) {
-                                E[old_color]--;
-                        } else if (S[i].color == new_color) {
-                                E[new_color]++;
+        kc->nodes = malloc(n * sizeof(int));
+        kc->marks = calloc(n, sizeof(unsigned));
+        if (!kc->nodes || !kc->marks) ALLOCATION_ERROR();
+
+        kc->size = 0;
+        kc->stamp = 0;
+}
+
+static void
+kempe_chain_free(KempeChain *kc) {
+        free(kc->nodes);
+        free(kc->marks);
+}
+
+/**
+ * Finds the Kempe chain of a node and a second color by a breadth first
+ * search from the node.  The search gives up once it has found more than
+ * KEMPE_MAX_NODES nodes, so finding and making an interchange costs no
+ * more than KEMPE_MAX_NODES single node moves; a chain spanning most of two
+ * color classes only relabels them anyway.
+ * @param Graph *g
+ *      The instance graph for the coloring problem.
+ * @param Node *S
+ *      The current solution.
+ * @param KempeChain *kc
+ *      Receives the chain.
+ * @param int u
+ *      The node at which the chain starts.  Its color is the chain's color a.
+ * @param int b
+ *      The chain's second color, different from the color of u.
+ *
+ * @return
+ *      1 if the chain was found, 0 if it is too large.
+ */
+static int
+find_kempe_chain(Graph *g, Node *S, KempeChain *kc, int u, int b) {
+
+        int i, v, w, head;
+
+        kc->a = S[u].color;
+        kc->b = b;
+
+        if (++kc->stamp == 0) {
+                /* The stamps wrapped around; clear them once. */
+                memset(kc->marks, 0, g->n * sizeof(unsigned));
+                kc->stamp = 1;
+        }
+
+        kc->nodes[0] = u;
+        kc->size = 1;
+        kc->marks[u] = kc->stamp;
+
+        for (head = 0; head < kc->size; head++) {
+                v = kc->nodes[head];
+                for (i = g->offsets[v]; i < g->offsets[v + 1]; i++) {
+                        w = g->neighbors[i];
+                        if ((S[w].color == kc->a || S[w].color == b) &&
+                            kc->marks[w] != kc->stamp) {
+                                if (kc->size == KEMPE_MAX_NODES) return 0;
+                                kc->marks[w] = kc->stamp;
+                                kc->nodes[kc->size++] = w;
                         }
                 }
         }
+
+        return 1;
+}
+
+/**
+ * Calculate the cost of exchanging the two colors of a Kempe chain without
+ * committing to updating the color class and bad edge data structures.
+ * Only the classes a and b change: the chain's nodes colored a move to b
+ * and those colored b to a, and so do the bad edges among them, since every
+ * bad edge at a node of the chain lies within the chain.
+ * @param Node *S
+ *      The current solution.
+ * @param int *A
+ *      Neighbour color counts of S.
+ * @param int k
+ *      The number of colors counted in A.
+ * @param int *C
+ *      Color classes data structure.
+ * @param int *E
+ *      Bad edges data structure.
+ * @param int neighbour_cost
+ *      The cost of S.
+ * @param KempeChain *kc
+ *      The chain, as found by find_kempe_chain() in S.
+ */
+static int
+calculate_kempe_chain_cost(Node *S, int *A, int k, int *C, int *E,
+    int neighbour_cost, KempeChain *kc) {
+
+        int i, v, a = kc->a, b = kc->b, n_a = 0, n_b = 0, e_a = 0, e_b = 0,
+            C_a, C_b, E_a, E_b, cost = neighbour_cost;
+
+        for (i = 0; i < kc->size; i++) {
+                v = kc->nodes[i];
+                if (S[v].color == a) {
+                        n_a++;
+                        e_a += A[(size_t) v * (k + 1) + a];
+                } else {
+                        n_b++;
+                        e_b += A[(size_t) v * (k + 1) + b];
+                }
+        }
+
+        /* Each bad edge was counted at both of its endpoints. */
+        e_a /= 2;
+        e_b /= 2;
+
+        cost -= (2 * C[a] * E[a]) - (C[a] * C[a]);
+        cost -= (2 * C[b] * E[b]) - (C[b] * C[b]);
+
+        C_a = C[a] - n_a + n_b;
+        C_b = C[b] - n_b + n_a;
+        E_a = E[a] - e_a + e_b;
+        E_b = E[b] - e_b + e_a;
+
+        cost += (2 * C_a * E_a) - (C_a * C_a);
+        cost += (2 * C_b * E_b) - (C_b * C_b);
+
+        return cost;
+}
+
+/**
+ * Exchanges the two colors of a Kempe chain in the solution, updating the
+ * color class, bad edge and neighbour color count data structures.
+ */
+static void
+apply_kempe_chain(Graph *g, Node *S, int *A, int k, int *C, int *E,
+    KempeChain *kc) {
+
+        int i, v, old_color, new_color;
+
+        for (i = 0; i < kc->size; i++) {
+                v = kc->nodes[i];
+                old_color = S[v].color;
+                new_color = old_color == kc->a ? kc->b : kc->a;
+                update_color_classes(C, v, old_color, new_color);
+                update_bad_edges(g, A, k, E, v, old_color, new_color);
+                S[v].color = new_color;
+        }
 }
 
 /**
  * Produces an initial solution to the coloring problem using the DSATUR
  * algorithm.
+ *
+ * Uncolored nodes are kept in a bucket queue keyed by their saturation
+ * degree, ties broken by degree: the key of a node is
+ * saturation * D + r, where D is the number of distinct degrees in the graph
+ * and r the rank of the node's degree among them.  Coloring a node only
+ * raises the saturation degree of its neighbors, so only they are moved to
+ * new buckets.
  * @param Graph *g
  *      Pointer to the graph specifying the instance of the problem to be
  *      solved.
@@ -444,33 +1378,51 @@ update_bad_edges(Graph *g, Node *S, int *E, int u, int old_color, int new_color)
 static void
 produce_initial_solution(Graph *g) {
 
-        PQueue *pq;
+        BucketQueue *q;
+        ColorScratch *scratch;
         Node *u;
-        double pri;
-        int c;
+        int *rank;                      /* rank[d] is the rank of degree d
+                                           among the distinct degrees. */
+        int i, v, D = 0;
 
-        pq = pqueue_init(g->n, node_calculate_priority);        
+        rank = calloc(g->n, sizeof(int));
+        if (!rank) ALLOCATION_ERROR();
 
-        update_pqueue_priorities(g, pq); 
+        for (i = 0; i < g->n; i++) rank[g->nodes[i].degree] = 1;
+        for (i = 0; i < g->n; i++) {
+                if (rank[i]) rank[i] = D++;
+        }
 
-        pqueue_dequeue(pq, (void **) &u, NULL);
+        q = bucket_queue_init(g->n, 16 * D);
+        scratch = color_scratch_init(g->n);
 
-        u->color = 1;
+        for (i = 0; i < g->n; i++) {
+                u = &g->nodes[i];
+                if (!u->color) bucket_queue_push(q, i, u->saturation_degree *
+                                D + rank[u->degree]);
+        }
 
-        graph_update_saturation_degrees(g, u);
-        update_pqueue_priorities(g, pq);
+        while (!bucket_queue_is_empty(q)) {
 
-        while (!pqueue_is_empty(pq)) {
+                u = &g->nodes[bucket_queue_pop(q)];
 
-                pqueue_dequeue(pq, (void **) &u, &pri);
-               
-                c = graph_get_lowest_available_color(g, u);
+                graph_color_node(g, u->id,
+                                graph_get_lowest_available_color(g, u, scratch));
 
-                u->color = c;
-               
                 graph_update_saturation_degrees(g, u);
-                update_pqueue_priorities(g, pq);
+
+                for (i = g->offsets[u->id]; i < g->offsets[u->id + 1]; i++) {
+                        v = g->neighbors[i];
+                        if (bucket_queue_contains(q, v))
+                                bucket_queue_update(q, v,
+                                        g->nodes[v].saturation_degree * D +
+                                        rank[g->nodes[v].degree]);
+                }
         }
+
+        bucket_queue_free(q);
+        color_scratch_free(scratch);
+        free(rank);
 #ifdef DEBUG
         /*
          * If debug flag defined, validate results of output. 
@@ -480,20 +1432,3 @@ produce_initial_solution(Graph *g) {
 
 #endif
 }
-
-static void
-update_pqueue_priorities(Graph *g, PQueue *pq) {
-
-        Node *n;
-        int i;
-
-        assert(g != NULL);
-        assert(pq != NULL);
-
-        pqueue_reset(pq);
-
-        for (i = 0; i < g->n; i++) {
-                n = &(g->nodes[i]);
-                if (!n->color) pqueue_enqueue(pq, (void *) n);
-        }
-}
@@ -3,6 +3,15 @@
 
 #include "graph.h"
 
-char *solve_coloring_instance(Graph *g);
+char *solve_coloring_instance(Graph *g, int threads, double kempe,
+    unsigned long seed);
+
+char *solve_coloring_instance_tabucol(Graph *g, int target, double seconds,
+    unsigned long seed);
+
+char *solve_coloring_instance_tempering(Graph *g, double seconds,
+    double kempe, unsigned long seed);
+
+char *coloring_solution_string(Graph *g, int optimal);
 
 #endif
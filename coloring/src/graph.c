@@ -27,7 +27,8 @@ int_comp(const void *a, const void *b) {
 }
 
 /**
- * Initializes and returns pointer to Graph struct with given number of nodes.
+ * Initializes and returns pointer to Graph struct with given number of nodes
+ * and no edges.
  * @param int nNodes
  *      The number of nodes in the graph to be constructed.
  */
@@ -39,35 +40,25 @@ graph_init(int nNodes) {
 
         assert(nNodes > 0);
 
-        g = malloc(sizeof(Graph));
+        g = calloc(1, sizeof(Graph));
         if (!g) graph_allocation_error();
 
         g->n = nNodes;
 
-        g->nodes = malloc(g->n * sizeof(Node));
+        g->nodes = calloc(g->n, sizeof(Node));
         if (!g->nodes) graph_allocation_error(); 
 
-        g->adj = malloc(g->n * sizeof(char *));
-        if (!g->adj) graph_allocation_error();
-
         for (i = 0; i < g->n; i++) {
-
                 g->nodes[i].id = i;
-                g->nodes[i].color = 0;
                 g->nodes[i].n = g->n;
-                /* 
-                 * Use calloc such that graph initially assumes no edges
-                 * between nodes. 
-                 */
-                g->adj[i] = calloc(g->n, sizeof(char));
-                if (!g->adj[i]) graph_allocation_error();
         }
 
         return g;
 }
 
 /**
- * Add an edge between nodes with the given ids in the graph.
+ * Add an edge between nodes with the given ids in the graph.  The edge is
+ * part of the adjacency once graph_finalize() is called.
  * @param Graph *g
  *      The graph to which to add the edge.
  * @param int u
@@ -78,137 +69,251 @@ graph_init(int nNodes) {
 void
 graph_add_edge(Graph *g, int u, int v) {
 
-        Node *n;
-        
         assert(g != NULL);
-        assert(u< g->n && v < g->n);
+        assert(g->offsets == NULL);
+        assert(u >= 0 && v >= 0 && u < g->n && v < g->n);
+
+        if (g->nEdges == g->szEdges) {
+                g->szEdges = g->szEdges ? 2 * g->szEdges : 1024;
+                g->edges = realloc(g->edges, 2 * (size_t) g->szEdges *
+                                sizeof(int));
+                if (!g->edges) graph_allocation_error();
+        }
+
+        g->edges[2 * (size_t) g->nEdges] = u;
+        g->edges[2 * (size_t) g->nEdges + 1] = v;
+        g->nEdges++;
+}
+
+/**
+ * Builds the compressed sparse row adjacency of the graph from the edges
+ * added, dropping self loops and repeated edges, and sets the degree of
+ * every node.  No edges may be added afterwards.
+ * @param Graph *g
+ *      The graph whose adjacency is to be built.
+ */
+void
+graph_finalize(Graph *g) {
+
+        int *fill, i, j, k, u, v;
 
-        g->adj[u][v] = (char) 1;
-        g->adj[v][u] = (char) 1;
+        assert(g != NULL);
+        assert(g->offsets == NULL);
+
+        g->offsets = calloc(g->n + 1, sizeof(int));
+        fill = malloc(g->n * sizeof(int));
+        if (!g->offsets || !fill) graph_allocation_error();
+
+        /* Count the entries of each row, then place them. */
+        for (i = 0; i < g->nEdges; i++) {
+                u = g->edges[2 * (size_t) i];
+                v = g->edges[2 * (size_t) i + 1];
+                if (u == v) continue;
+                g->offsets[u + 1]++;
+                g->offsets[v + 1]++;
+        }
+        for (u = 0; u < g->n; u++) {
+                g->offsets[u + 1] += g->offsets[u];
+                fill[u] = g->offsets[u];
+        }
 
-        n = &(g->nodes[u]);
-        n->degree++;
+        g->neighbors = malloc(((size_t) g->offsets[g->n] + 1) * sizeof(int));
+        if (!g->neighbors) graph_allocation_error();
 
-        n = &(g->nodes[v]);
-        n->degree++;
+        for (i = 0; i < g->nEdges; i++) {
+                u = g->edges[2 * (size_t) i];
+                v = g->edges[2 * (size_t) i + 1];
+                if (u == v) continue;
+                g->neighbors[fill[u]++] = v;
+                g->neighbors[fill[v]++] = u;
+        }
+
+        free(g->edges);
+        g->edges = NULL;
+        g->nEdges = g->szEdges = 0;
+
+        /* Sort each row and squeeze out repeated edges in place. */
+        k = 0;
+        for (u = 0; u < g->n; u++) {
+                i = g->offsets[u];
+                j = g->offsets[u + 1];
+                qsort(&g->neighbors[i], j - i, sizeof(int), int_comp);
+
+                g->offsets[u] = k;
+                for (; i < j; i++) {
+                        if (k > g->offsets[u] && g->neighbors[k - 1] ==
+                            g->neighbors[i])
+                                continue;
+                        g->neighbors[k++] = g->neighbors[i];
+                }
+                g->nodes[u].degree = k - g->offsets[u];
+        }
+        g->offsets[g->n] = k;
+        g->m = k / 2;
+
+        free(fill);
 }
 
 /**
- * Delete an edge between nodes with the given ids in the graph.
+ * Frees the graph and everything it holds.
+ */
+void
+graph_free(Graph *g) {
+        if (!g) return;
+        free(g->nodes);
+        free(g->offsets);
+        free(g->neighbors);
+        free(g->edges);
+        free(g->adjacent_colors);
+        free(g);
+}
+
+/**
+ * Colors the node with the given id.
  * @param Graph *g
- *      The graph to which to add the edge.
+ *      Pointer to graph instance.
  * @param int u
- *      The id of the first node in the edge.
- * @param int v
- *      The id of the second node in the edge.
+ *      The id of the node to be colored.
+ * @param int c
+ *      The color given to the node, 0 to uncolor it.
  */
 void
-graph_remove_edge(Graph *g, int u, int v) {
+graph_color_node(Graph *g, int u, int c) {
 
-        Node *n;
-        assert(g != NULL);
-        assert(u < g->n && v < g->n);
+        g->nodes[u].color = c;
+}
+
+/**
+ * Widens the rows of adjacent colors of the graph to hold color c.
+ */
+static void
+graph_grow_adjacent_colors(Graph *g, int c) {
 
-        g->adj[u][v] = (char) 0;
-        g->adj[v][u] = (char) 0;
+        uint64_t *bits;
+        int u, words = g->color_words ? g->color_words : 1;
 
-        n = &(g->nodes[u]);
-        n->degree++;
+        while (c >= 64 * words) words *= 2;
 
-        n = &(g->nodes[v]);
-        n->degree++;
-}
+        bits = calloc((size_t) g->n * words, sizeof(uint64_t));
+        if (!bits) graph_allocation_error();
+
+        for (u = 0; u < g->n && g->adjacent_colors; u++) {
+                memcpy(bits + (size_t) u * words,
+                                g->adjacent_colors + (size_t) u *
+                                g->color_words,
+                                g->color_words * sizeof(uint64_t));
+        }
 
+        free(g->adjacent_colors);
+        g->adjacent_colors = bits;
+        g->color_words = words;
+}
 
 /**
- * Updates the saturation degrees for each node in the graph.
- * TODO: clean up this implementation.
+ * Updates the saturation degrees of the neighbors of a node just colored,
+ * the only nodes whose saturation degree can change.  A neighbor's
+ * saturation degree is raised only if no other neighbor of it has the same
+ * color, so it counts distinct colors.  Nodes are assumed not to be
+ * recolored afterwards.
  * @param Graph *g
  *      Pointer to the graphs for which saturation degrees are to be 
  *      calculated.
+ * @param Node *n
+ *      The node just colored.
  */
 void
 graph_update_saturation_degrees(Graph *g, Node *n) {
 
-        int i;
+        uint64_t *word, mask;
+        int i, v, c;
         
         assert(g != NULL);
         assert(n != NULL);
 
-        for (i = 0; i < g->n; i++) {
-                if (i == n->id) continue;
-
-                if (g->adj[n->id][i] == (char)1 && 
-                    g->nodes[i].color != n->color)
-                        g->nodes[i].saturation_degree++;
+        c = n->color;
+        if (c >= 64 * g->color_words) graph_grow_adjacent_colors(g, c);
+        mask = (uint64_t) 1 << (c % 64);
+
+        for (i = g->offsets[n->id]; i < g->offsets[n->id + 1]; i++) {
+                v = g->neighbors[i];
+                word = &g->adjacent_colors[(size_t) v * g->color_words +
+                        c / 64];
+                if (!(*word & mask)) {
+                        *word |= mask;
+                        g->nodes[v].saturation_degree++;
+                }
         }       
 }
 
 /**
- * Returns the saturation degree of the given node.  Implements the interface
- * defined by the pqueue module.
+ * Initializes and returns scratch space for lowest color lookups in graphs
+ * of n nodes.
  */
-double
-node_calculate_priority(void *x) {
-        Node *n = (Node *)x;
-        return (double) ( (double) n->saturation_degree) + 
-                ( (double) n->degree / (double) n->n);
+ColorScratch *
+color_scratch_init(int n) {
+
+        ColorScratch *s;
+
+        s = malloc(sizeof(ColorScratch));
+        if (!s) graph_allocation_error();
+
+        /* A node of degree d always has a free color in 1..d+1. */
+        s->size = n + 2;
+        s->stamps = calloc(s->size, sizeof(unsigned));
+        if (!s->stamps) graph_allocation_error();
+        s->generation = 0;
+
+        return s;
+}
+
+void
+color_scratch_free(ColorScratch *s) {
+        if (!s) return;
+        free(s->stamps);
+        free(s);
 }
 
 /**
  * Given a pointer to a graph and a node in that graph, return the integer
  * representing the lowest color which could be used to legally color the
  * given node.
- * WARNING: non-reentrant, uses static state structure.
+ *
+ * The colors of the neighbors of u are marked in the scratch space, only
+ * those up to the degree of u + 1 as a lower color is always free, and the
+ * first unmarked color is returned, in O(degree of u).
  * @param Graph *g
  *      Pointer to graph instance.
  * @param Node *u
  *      The node to be colored.
+ * @param ColorScratch *s
+ *      Scratch space for a graph of at least as many nodes, owned by the
+ *      calling thread.
  */
 int
-graph_get_lowest_available_color(Graph *g, Node *u) {
+graph_get_lowest_available_color(Graph *g, Node *u, ColorScratch *s) {
 
-        static int *colors = NULL;
-        Node *v;
-        static int colors_size = 0;
-        int i, lowest_color = 1;
+        int i, c, limit;
 
         assert(g != NULL);
         assert(u != NULL);
-        
-        if (!colors) {
-                colors = calloc(g->n, sizeof(int));
-                if (!colors) graph_allocation_error();         
-        } else {
-                memset(colors, '\0', (colors_size + 1) * sizeof(int));
-                colors_size = 0;
-        }
+        assert(s != NULL && s->size >= g->n + 2);
 
-        /* Populate colors array with colors of neighbours of u. */
-        for (i = 0; i < g->n; i++) {
-
-                if (g->adj[u->id][i] == (char) 1) {
-
-                        v = &(g->nodes[i]);
-                       
-                        if (v->color) 
-                                colors[colors_size++] = v->color;                        
-                }
+        if (++s->generation == 0) {
+                /* The stamps wrapped around; clear them once. */
+                memset(s->stamps, 0, s->size * sizeof(unsigned));
+                s->generation = 1;
         }
 
-        /* Sort array of colors found. */
-        qsort(colors, colors_size, sizeof(int), int_comp);
+        limit = u->degree + 1;
+        for (i = g->offsets[u->id]; i < g->offsets[u->id + 1]; i++) {
+                c = g->nodes[g->neighbors[i]].color;
+                if (c <= limit) s->stamps[c] = s->generation;
+        }
 
-        /* Find and return lowest color. */
-        for (i = 0; i < (colors_size - 1); i++) {
+        for (c = 1; s->stamps[c] == s->generation; c++)
+                ;
 
-                if (colors[i] > lowest_color) return lowest_color;
-                else if ( (colors[i+1] - colors[i]) > 1) return colors[i] + 1;
-                
-                lowest_color = colors[i] + 1;               
-        }
-        // i = colors_size - 1
-        return colors[i] + 1;
+        return c;
 }
 
 
@@ -230,13 +335,11 @@ graph_is_valid_coloring(Graph *g, int debug) {
 
                 u = g->nodes[i];
 
-                for (j = 0; j < g->n; j++) {
-
-                        if (i == j) continue;
+                for (j = g->offsets[i]; j < g->offsets[i + 1]; j++) {
 
-                        v = g->nodes[j];
+                        v = g->nodes[g->neighbors[j]];
 
-                        if (g->adj[i][j] == 1 && v.color == u.color) {
+                        if (v.color == u.color) {
 
                                 if (debug)
                                         fprintf(stderr, "Adjacent nodes %d "
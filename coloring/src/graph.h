@@ -5,10 +5,12 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
+#include <stdint.h>
+
 typedef struct {
         /** 
          * Id of graph (i.e., its index in Graph.nodes and
-         * Graph.adjacency matrix.
+         * Graph.offsets.
          */
         int id;
 
@@ -19,7 +21,8 @@ typedef struct {
         int degree;
 
         /**
-         * The number of colors to which the node is adjacent.
+         * The number of distinct colors to which the node is adjacent, kept
+         * by graph_update_saturation_degrees().
          */
         int saturation_degree;
 
@@ -38,6 +41,23 @@ typedef struct {
         Node v;
 } Edge;
 
+/*
+ * Caller-owned scratch space of graph_get_lowest_available_color(), so
+ * lookups need no allocation and may run concurrently with one scratch per
+ * thread.  A color is marked in the current lookup if its stamp equals the
+ * generation, so marks are cleared by incrementing the generation.
+ */
+typedef struct {
+        /** stamps[c] is the generation of the last lookup which marked c. */
+        unsigned *stamps;
+
+        /** Number of colors which can be marked, 0..size-1. */
+        int size;
+
+        /** The generation of the current lookup. */
+        unsigned generation;
+} ColorScratch;
+
 typedef struct {
         
         /** Number of nodes in the graph. */
@@ -46,9 +66,41 @@ typedef struct {
         /** Array of nodes in the graph. */
         Node *nodes;
 
-        /** Adjacency matrix encoding edges. */
-        char **adj;
+        /**
+         * Adjacency in compressed sparse row form: the neighbors of node u
+         * are neighbors[offsets[u]] to neighbors[offsets[u+1] - 1], in
+         * increasing order.  Built by graph_finalize().
+         *
+         * There is deliberately no bitset adjacency matrix for dense
+         * graphs.  Its popcount queries, the neighbors of a node in a
+         * color class, are answered in O(1) by the annealer's neighbor
+         * color counts and Tabucol's gamma table, and DSATUR keeps
+         * adjacent_colors below, so every consumer walks rows once per
+         * move and the matrix would only cost memory.
+         */
+        int *offsets;
+        int *neighbors;
 
+        /** Number of edges in the graph. */
+        int m;
+
+        /**
+         * The colors adjacent to each node, as one bitset over the colors
+         * per node: color c is adjacent to node u if bit c % 64 of
+         * adjacent_colors[u * color_words + c / 64] is set.  Kept by
+         * graph_update_saturation_degrees(), which widens the rows as higher
+         * colors are used.
+         */
+        uint64_t *adjacent_colors;
+        int color_words;
+
+        /**
+         * Edges added since the graph was initialized, as pairs of node ids,
+         * until graph_finalize() builds the adjacency from them.
+         */
+        int *edges;
+        int nEdges;
+        int szEdges;
 
 } Graph;
 
@@ -56,13 +108,17 @@ Graph * graph_init(int);
 
 void graph_add_edge(Graph *, int, int);
 
-void graph_remove_edge(Graph *, int, int);
+void graph_finalize(Graph *);
 
-void graph_get_adjacent_nodes(Graph *, int);
+void graph_free(Graph *);
 
 void graph_color_node(Graph *, int, int);
 
-int graph_get_lowest_available_color(Graph *, Node *);
+ColorScratch *color_scratch_init(int);
+
+void color_scratch_free(ColorScratch *);
+
+int graph_get_lowest_available_color(Graph *, Node *, ColorScratch *);
 
 void graph_copy_nodes(Graph *, Node **);
 
@@ -70,6 +126,4 @@ void graph_update_saturation_degrees(Graph *, Node *);
 
 int graph_is_valid_coloring(Graph *, int);
 
-double node_calculate_priority(void *);
-
 #endif
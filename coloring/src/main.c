@@ -3,16 +3,65 @@
  */
 
 #include <assert.h>
+#include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "coloring_solver.h"
 #include "graph.h"
+#include "perf.h"
+#include "stats.h"
 #include "utils.h"
 
 #define MAX_LINE_LENGTH 128
-#define NARGS 2
+#define NARGS 1
+
+/*
+ * Local searches which may be requested on the cmd line.
+ */
+typedef enum {
+        METHOD_ANNEAL,          /* Simulated annealing. */
+        METHOD_TABUCOL,         /* Tabu search removing one color at a
+                                   time. */
+        METHOD_TEMPERING        /* Replica exchange. */
+} Method;
+
+/*
+ * Structure holding the options given on the cmd line.
+ */
+typedef struct {
+        /** Path to the input file. */
+        char *path;
+
+        /** The local search to be used. */
+        Method method;
+
+        /**
+         * Number of colors at which Tabucol stops removing colors.  0 to
+         * continue as long as colorings are found.
+         */
+        int colors;
+
+        /** Number of annealing chains, each run on its own thread. */
+        int threads;
+
+        /** Seed of the random number generators. */
+        unsigned long seed;
+
+        /** Wall time in seconds for which Tabucol or replica exchange
+         * runs. */
+        double seconds;
+
+        /** Fraction of annealing moves which are Kempe chain
+         * interchanges. */
+        double kempe;
+
+        /** Flag indicating counters describing the run are to be written to
+         * stderr as JSON. */
+        int stats;
+} Options;
 
 /**
  * Prints usage message on passing of bad cmd line args.
@@ -20,7 +69,41 @@
 static void
 usage() {
         extern char * __progname;
-        fprintf(stderr, "Usage: ./%s { path to input file }\n", __progname);
+        fprintf(stderr, "Usage: ./%s [--method M] [--colors K] [--threads N] "
+                        "[--time T]\n"
+                        "       [--kempe P] [--seed S] [--stats] "
+                        "{ path to input file }\n",
+                        __progname);
+        fprintf(stderr, "  -m, --method M     local search to use: tabucol "
+                        "(default), anneal\n"
+                        "                     or tempering (replica "
+                        "exchange)\n");
+        fprintf(stderr, "  -k, --colors K     stop once tabucol finds a "
+                        "coloring with K\n"
+                        "                     colors (default: continue "
+                        "while colorings are found)\n");
+        fprintf(stderr, "  -j, --threads N    run N independent annealing "
+                        "chains on N threads,\n"
+                        "                     keeping the best solution "
+                        "(default 1)\n");
+        fprintf(stderr, "  -t, --time T       seconds for which tabucol "
+                        "or tempering run\n"
+                        "                     (default 10)\n");
+        fprintf(stderr, "  --kempe P          make a fraction P of the moves "
+                        "of anneal and\n"
+                        "                     tempering Kempe chain "
+                        "interchanges (default 0)\n");
+        fprintf(stderr, "  --seed S           seed of the random number "
+                        "generators (default:\n"
+                        "                     the current time); the same "
+                        "seed and options\n"
+                        "                     give the same solution\n");
+        fprintf(stderr, "  --stats            write counters describing the "
+                        "run, and hardware\n"
+                        "                     counters of each phase, to "
+                        "stderr as JSON\n");
+        fprintf(stderr, "-k, -j, -t and --kempe are rejected by the methods "
+                        "which do not use them.\n");
         exit(1);
 }
 
@@ -35,33 +118,150 @@ format_error(int lineno) {
 }
 
 static void
-parse_args(int, char **, Graph **);
+parse_args(int, char **, Options *);
+
+static void
+read_graph(char *, Graph **);
 
 int
 main(int argc, char **argv) {
 
+        Options opts;
         Graph *g;
+        char *sol;
+
+        parse_args(argc, argv, &opts);
+
+        if (opts.stats) stats_perf_open();
 
-        parse_args(argc, argv, &g);
+        stats_phase_begin(PHASE_PARSE);
+        read_graph(opts.path, &g);
+        stats_phase_end(PHASE_PARSE);
 
-        solve_coloring_instance(g);
+        stats.seed = opts.seed;
+        if (opts.method == METHOD_TABUCOL)
+                sol = solve_coloring_instance_tabucol(g, opts.colors,
+                                opts.seconds, opts.seed);
+        else if (opts.method == METHOD_TEMPERING)
+                sol = solve_coloring_instance_tempering(g, opts.seconds,
+                                opts.kempe, opts.seed);
+        else
+                sol = solve_coloring_instance(g, opts.threads, opts.kempe,
+                                opts.seed);
+
+        stats_phase_begin(PHASE_OUTPUT);
+        if (sol) printf("%s", sol);
+        fflush(stdout);
+        stats_phase_end(PHASE_OUTPUT);
+
+        if (opts.stats) {
+                stats_print_json(stderr);
+                perf_close();
+        }
 
         return 0;
 }
 
-
 /**
- * Parse command line args and initialize Graph instance to be used by
- * the solver.
+ * Parse command line args.
  * @param int argc
  *      argc as passed at program execution.
  * @param char **argv
  *      argv as passed at program execution.
+ * @param Options *opts
+ *      Pointer to the structure into which the parsed options are stored.
+ */
+static void
+parse_args(int argc, char **argv, Options *opts) {
+
+        static struct option long_options[] = {
+                {"method", required_argument, NULL, 'm'},
+                {"colors", required_argument, NULL, 'k'},
+                {"threads", required_argument, NULL, 'j'},
+                {"time", required_argument, NULL, 't'},
+                {"kempe", required_argument, NULL, 'p'},
+                {"seed", required_argument, NULL, 'r'},
+                {"stats", no_argument, NULL, 'T'},
+                {NULL, 0, NULL, 0}
+        };
+        char *err;
+        int c, given_threads = 0, given_time = 0, given_kempe = 0;
+
+        memset(opts, 0, sizeof(Options));
+        opts->method = METHOD_TABUCOL;
+        opts->threads = 1;
+        opts->seconds = 10;
+        opts->seed = (unsigned long) time(NULL);
+
+        while ((c = getopt_long(argc, argv, "m:k:j:t:", long_options, NULL))
+            != -1) {
+                switch (c) {
+                case 'm':
+                        if (strcmp(optarg, "anneal") == 0)
+                                opts->method = METHOD_ANNEAL;
+                        else if (strcmp(optarg, "tabucol") == 0)
+                                opts->method = METHOD_TABUCOL;
+                        else if (strcmp(optarg, "tempering") == 0)
+                                opts->method = METHOD_TEMPERING;
+                        else
+                                usage();
+                        break;
+                case 'k':
+                        opts->colors = (int) strtol(optarg, &err, 10);
+                        if (err[0] != '\0' || opts->colors < 1) usage();
+                        break;
+                case 'j':
+                        opts->threads = (int) strtol(optarg, &err, 10);
+                        if (err[0] != '\0' || opts->threads < 1) usage();
+                        given_threads = 1;
+                        break;
+                case 't':
+                        opts->seconds = strtod(optarg, &err);
+                        if (err[0] != '\0' || opts->seconds <= 0) usage();
+                        given_time = 1;
+                        break;
+                case 'p':
+                        opts->kempe = strtod(optarg, &err);
+                        if (err[0] != '\0' || opts->kempe < 0 ||
+                            opts->kempe > 1)
+                                usage();
+                        given_kempe = 1;
+                        break;
+                case 'r':
+                        opts->seed = strtoul(optarg, &err, 10);
+                        if (err[0] != '\0') usage();
+                        break;
+                case 'T':
+                        opts->stats = 1;
+                        break;
+                default:
+                        usage();
+                }
+        }
+
+        if (argc - optind != NARGS) {
+                usage();
+        }
+
+        /* Reject options which the chosen method would ignore. */
+        if (opts->colors && opts->method != METHOD_TABUCOL) usage();
+        if (given_threads && opts->method != METHOD_ANNEAL) usage();
+        if (given_time && opts->method == METHOD_ANNEAL) usage();
+        if (given_kempe && opts->method == METHOD_TABUCOL) usage();
+
+        opts->path = argv[optind];
+}
+
+/**
+ * Read the instance in the given file and initialize Graph instance to be
+ * used by the solver.
+ * @param char *path
+ *      Path to the input file.
  * @param Graph **g
  *      Address of pointer to graph structure to be initialized.
  */
 static void
-parse_args(int argc, char **argv, Graph **g) {
+read_graph(char *path, Graph **g) {
 
         char buf[MAX_LINE_LENGTH];
         char delimiters[] = " \n";
@@ -69,14 +269,10 @@ parse_args(int argc, char **argv, Graph **g) {
         FILE *in;
         int lineno = 0, u, v, n;
 
-        if (argc != NARGS) {
-                usage();
-        }
-
-        in = fopen(argv[1], "r");
+        in = fopen(path, "r");
         if (!in) {
                 fprintf(stderr, "Input file %s could not be opened.\n",
-                                argv[1]);
+                                path);
                 exit(1);
         }
 
@@ -88,6 +284,7 @@ parse_args(int argc, char **argv, Graph **g) {
                 if (lineno == 0) {
                         
                         token = strtok(buf, delimiters);
+                        if (!token) format_error(lineno);
                         n = (int) strtol(token, &err, 10);
 
                         if (err[0] != '\0' || n <= 0) format_error(lineno);
@@ -99,21 +296,33 @@ parse_args(int argc, char **argv, Graph **g) {
                 } else {
                         /* Get endpoints of edge being define. */
                         token = strtok(buf, delimiters);
+                        if (!token) format_error(lineno);
                         u = (int) strtol(token, &err, 10);                  
 
                         if (err[0] != '\0') format_error(lineno);
 
                         token = strtok(NULL, delimiters);
+                        if (!token) format_error(lineno);
                         v = (int) strtol(token, &err, 10);
                         
                         if (err[0] != '\0') format_error(lineno);
 
+                        if (u < 0 || v < 0 || u >= n || v >= n)
+                                format_error(lineno);
+
                         graph_add_edge(*g, u, v);
 
                 }
                 lineno++;
         }
 
+        fclose(in);
+
+        /* An empty file has no header. */
+        if (lineno == 0) format_error(0);
+
+        /* Build the adjacency of the graph from the edges read. */
+        graph_finalize(*g);
 
 }
 
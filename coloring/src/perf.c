@@ -0,0 +1,160 @@
+/*
+ * Module implementing access to the hardware performance counters of the
+ * CPU through Linux perf_event_open.
+ *
+ * Each event is opened on its own rather than as a group, so an event the
+ * CPU or the kernel does not provide (e.g. in a virtual machine, or with
+ * perf_event_paranoid > 2) is reported as unavailable without losing the
+ * others.  Events count user space only, which perf_event_paranoid = 2
+ * still allows, and are inherited by threads created after they are opened.
+ * Events share few counters, so each count is scaled by the time its event
+ * was enabled over the time it was counting.
+ * On other systems every event is unavailable.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perf.h"
+
+static const char *event_names[N_PERF_EVENTS] = {
+        "cycles", "instructions", "cache_misses", "branch_misses"
+};
+
+#ifdef __linux__
+static const unsigned long long event_configs[N_PERF_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+};
+#endif
+
+/*
+ * File descriptors of the opened events, -1 for unavailable events.
+ */
+static int fds[N_PERF_EVENTS] = {-1, -1, -1, -1};
+
+/**
+ * Opens and starts the counters of the calling process.
+ * @return
+ *      The number of events which could be opened.
+ */
+int
+perf_open(void) {
+
+        int i, opened = 0;
+
+#ifdef __linux__
+        struct perf_event_attr attr;
+
+        for (i = 0; i < N_PERF_EVENTS; i++) {
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = event_configs[i];
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.inherit = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                        PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+                if (fds[i] >= 0) opened++;
+        }
+#else
+        for (i = 0; i < N_PERF_EVENTS; i++) fds[i] = -1;
+#endif
+
+        return opened;
+}
+
+/**
+ * Reads the current value of each counter and the times it was enabled and
+ * running, -1 for unavailable events.
+ */
+void
+perf_read(PerfCounts *counts) {
+
+        long long value[3];     /* Count, time enabled and time running. */
+        int i;
+
+        for (i = 0; i < N_PERF_EVENTS; i++) {
+#ifdef __linux__
+                if (fds[i] >= 0 && read(fds[i], value, sizeof(value)) ==
+                    sizeof(value)) {
+                        counts->count[i] = value[0];
+                        counts->enabled[i] = value[1];
+                        counts->running[i] = value[2];
+                        continue;
+                }
+#endif
+                counts->count[i] = -1;
+        }
+}
+
+/**
+ * Adds the counts between the readings start and end to total, scaled up to
+ * the time each event was enabled if it was not counting throughout.
+ * Events unavailable in either reading, or never counting in between, are
+ * marked unavailable in total.
+ */
+void
+perf_accumulate(PerfCounts *total, PerfCounts *start, PerfCounts *end) {
+
+        long long running;
+        int i;
+
+        for (i = 0; i < N_PERF_EVENTS; i++) {
+                running = end->running[i] - start->running[i];
+                if (start->count[i] < 0 || end->count[i] < 0 || running <= 0)
+                        total->count[i] = -1;
+                else if (total->count[i] >= 0)
+                        total->count[i] += (long long) ((double)
+                                (end->count[i] - start->count[i]) *
+                                (end->enabled[i] - start->enabled[i]) /
+                                running + 0.5);
+        }
+}
+
+/**
+ * Writes the given counts as a JSON object, with null for unavailable
+ * events.
+ */
+void
+perf_print_json(FILE *out, PerfCounts *counts) {
+
+        int i;
+
+        fprintf(out, "{");
+        for (i = 0; i < N_PERF_EVENTS; i++) {
+                fprintf(out, "%s\"%s\": ", i ? ", " : "", event_names[i]);
+                if (counts->count[i] < 0)
+                        fprintf(out, "null");
+                else
+                        fprintf(out, "%lld", counts->count[i]);
+        }
+        fprintf(out, "}");
+}
+
+/**
+ * Closes the counters.
+ */
+void
+perf_close(void) {
+
+        int i;
+
+        for (i = 0; i < N_PERF_EVENTS; i++) {
+#ifdef __linux__
+                if (fds[i] >= 0) close(fds[i]);
+#endif
+                fds[i] = -1;
+        }
+}
@@ -0,0 +1,53 @@
+/*
+ * Module defining access to the hardware performance counters of the CPU
+ * through Linux perf_event_open.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdio.h>
+
+/*
+ * Hardware events counted.
+ */
+typedef enum {
+        PERF_CYCLES,
+        PERF_INSTRUCTIONS,
+        PERF_CACHE_MISSES,
+        PERF_BRANCH_MISSES,
+        N_PERF_EVENTS
+} PerfEvent;
+
+/*
+ * Counts of the hardware events over some interval, or at some instant.  An
+ * event which could not be counted has a count of -1.
+ */
+typedef struct {
+        long long count[N_PERF_EVENTS];
+
+        /**
+         * Nanoseconds for which each event was enabled, and running on a
+         * counter, as of a reading.  The kernel multiplexes events over too
+         * few counters, so running may fall short of enabled.
+         */
+        long long enabled[N_PERF_EVENTS];
+        long long running[N_PERF_EVENTS];
+} PerfCounts;
+
+int
+perf_open(void);
+
+void
+perf_read(PerfCounts *);
+
+void
+perf_accumulate(PerfCounts *, PerfCounts *, PerfCounts *);
+
+void
+perf_print_json(FILE *, PerfCounts *);
+
+void
+perf_close(void);
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Fast pseudorandom number generator, xoshiro256** (Blackman and Vigna),
+ * seeded through splitmix64.  Each generator is independent state, so
+ * threads draw from their own generators without locking, and the numbers
+ * drawn depend only on the seed and stream a generator was seeded with.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+typedef struct {
+        uint64_t s[4];
+} Rng;
+
+static inline uint64_t
+rng_splitmix64(uint64_t *x) {
+        uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+}
+
+/* Seeds the generator for stream number stream of the given seed.  Distinct
+ * streams of a seed give unrelated sequences. */
+static inline void
+rng_seed(Rng *r, uint64_t seed, uint64_t stream) {
+        uint64_t x = seed ^ rng_splitmix64(&stream);
+        int i;
+        for (i = 0; i < 4; i++) r->s[i] = rng_splitmix64(&x);
+}
+
+static inline uint64_t
+rng_rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t
+rng_next(Rng *r) {
+        uint64_t *s = r->s, result = rng_rotl(s[1] * 5, 7) * 9, t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rng_rotl(s[3], 45);
+
+        return result;
+}
+
+/* Returns an integer uniform in [0, n), n > 0. */
+static inline int
+rng_below(Rng *r, int n) {
+        return (int) (((rng_next(r) >> 32) * (uint64_t) n) >> 32);
+}
+
+/* Returns a double uniform in [0, 1). */
+static inline double
+rng_uniform(Rng *r) {
+        return (rng_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Module implementing counters describing a run of the coloring solver.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "stats.h"
+
+/*
+ * Counters describing the current run.
+ */
+Stats stats;
+
+static const char *phase_names[N_PHASES] = {
+        "parse", "initial", "search", "output"
+};
+
+/**
+ * Returns the current value of a monotonic clock, in seconds.
+ */
+double
+stats_now(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Starts counting hardware events in each phase.  Events which cannot be
+ * counted are reported as null.
+ */
+void
+stats_perf_open(void) {
+        perf_open();
+        stats.perf = 1;
+}
+
+void
+stats_phase_begin(Phase p) {
+        if (stats.perf) perf_read(&stats.phase_perf_start[p]);
+        stats.phase_start[p] = stats_now();
+}
+
+void
+stats_phase_end(Phase p) {
+
+        PerfCounts end;
+
+        stats.phase_time[p] += stats_now() - stats.phase_start[p];
+
+        if (stats.perf) {
+                perf_read(&end);
+                perf_accumulate(&stats.phase_perf[p],
+                                &stats.phase_perf_start[p], &end);
+        }
+}
+
+/**
+ * Writes the counters of the current run as a single JSON object.
+ */
+void
+stats_print_json(FILE *out) {
+
+        struct rusage usage;
+        int i;
+
+        getrusage(RUSAGE_SELF, &usage);
+
+        fprintf(out, "{\"seed\": %lu, \"initial_colors\": %d, "
+                        "\"colors\": %d, \"moves\": {\"proposed\": %ld, "
+                        "\"accepted\": %ld}, ", stats.seed,
+                        stats.initial_colors, stats.colors,
+                        stats.moves_proposed, stats.moves_accepted);
+        fprintf(out, "\"kempe\": {\"proposed\": %ld, \"accepted\": %ld}, ",
+                        stats.kempe_proposed, stats.kempe_accepted);
+        fprintf(out, "\"swaps\": {\"proposed\": %ld, \"accepted\": %ld}, ",
+                        stats.swaps_proposed, stats.swaps_accepted);
+
+        fprintf(out, "\"phases\": {");
+        for (i = 0; i < N_PHASES; i++) {
+                fprintf(out, "%s\"%s\": %.6f", i ? ", " : "", phase_names[i],
+                                stats.phase_time[i]);
+        }
+        fprintf(out, "}, ");
+
+        if (stats.perf) {
+                fprintf(out, "\"perf\": {");
+                for (i = 0; i < N_PHASES; i++) {
+                        fprintf(out, "%s\"%s\": ", i ? ", " : "",
+                                        phase_names[i]);
+                        perf_print_json(out, &stats.phase_perf[i]);
+                }
+                fprintf(out, "}, ");
+        }
+
+        /* ru_maxrss is reported in kilobytes on Linux. */
+        fprintf(out, "\"peak_rss_kb\": %ld}\n", usage.ru_maxrss);
+}
@@ -0,0 +1,79 @@
+/*
+ * Module defining counters describing a run of the coloring solver,
+ * reported as JSON with --stats.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+#include "perf.h"
+
+/*
+ * Phases of a run which are timed.
+ */
+typedef enum {
+        PHASE_PARSE,    /* Reading the input file. */
+        PHASE_INITIAL,  /* Producing the initial solution with DSATUR. */
+        PHASE_SEARCH,   /* Improving the solution by annealing. */
+        PHASE_OUTPUT,   /* Writing the solution. */
+        N_PHASES
+} Phase;
+
+typedef struct {
+        /** Seed of the random number generators. */
+        unsigned long seed;
+
+        /** Number of colors used by the initial solution. */
+        int initial_colors;
+
+        /** Number of colors used by the best valid solution found. */
+        int colors;
+
+        /** Moves proposed and accepted by the local search. */
+        long moves_proposed;
+        long moves_accepted;
+
+        /** Kempe chain interchanges proposed and accepted by the local
+         * search. */
+        long kempe_proposed;
+        long kempe_accepted;
+
+        /** Exchanges of temperature proposed and accepted by replica
+         * exchange. */
+        long swaps_proposed;
+        long swaps_accepted;
+
+        /** Wall time spent in each phase, in seconds. */
+        double phase_time[N_PHASES];
+
+        /** Start of each phase, in seconds. */
+        double phase_start[N_PHASES];
+
+        /** Flag indicating hardware counters are read around each phase. */
+        int perf;
+
+        /** Hardware events counted in each phase, and at its start. */
+        PerfCounts phase_perf[N_PHASES];
+        PerfCounts phase_perf_start[N_PHASES];
+} Stats;
+
+extern Stats stats;
+
+double
+stats_now(void);
+
+void
+stats_perf_open(void);
+
+void
+stats_phase_begin(Phase);
+
+void
+stats_phase_end(Phase);
+
+void
+stats_print_json(FILE *);
+
+#endif
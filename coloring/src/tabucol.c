@@ -0,0 +1,238 @@
+/*
+ * Module implementing Tabucol (Hertz and de Werra, 1987), with the tabu
+ * tenure of Galinier and Hao (1999).
+ *
+ * The search holds a coloring with k colors which may have conflicting
+ * edges, those whose endpoints share a color, and at each iteration makes
+ * the best move recoloring a node on a conflicting edge.  A move is
+ * evaluated in O(1) from a table of the number of neighbors of each node
+ * with each color, as in the annealer.  Moving a node back to the color it
+ * left is tabu for a number of iterations, unless it gives a coloring with
+ * fewer conflicts than any seen so far (the aspiration criterion).
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+#include "tabucol.h"
+#include "utils.h"
+
+/*
+ * The tenure of a move is a random number of iterations below
+ * TABUCOL_TENURE plus TABUCOL_TENURE_FACTOR times the number of conflicting
+ * nodes.
+ */
+#define TABUCOL_TENURE 10
+#define TABUCOL_TENURE_FACTOR 0.6
+
+/*
+ * The nodes with at least one conflicting edge, as an array with the
+ * position of each node in it, -1 for nodes not in the set.
+ */
+typedef struct {
+        int *nodes;
+        int *pos;
+        int size;
+} ConflictSet;
+
+/**
+ * Adds node v to the set if it has a conflicting edge, and removes it
+ * otherwise.
+ */
+static void
+conflict_set_update(ConflictSet *s, int v, int conflicts) {
+
+        int last;
+
+        if (conflicts > 0 && s->pos[v] < 0) {
+                s->pos[v] = s->size;
+                s->nodes[s->size++] = v;
+        } else if (conflicts == 0 && s->pos[v] >= 0) {
+                last = s->nodes[--s->size];
+                s->nodes[s->pos[v]] = last;
+                s->pos[last] = s->pos[v];
+                s->pos[v] = -1;
+        }
+}
+
+/**
+ * Gives each node colored outside 1..k the color in 1..k shared by the
+ * fewest of its neighbors, so the search starts from a k-coloring close to
+ * the given one.
+ */
+static void
+tabucol_squeeze(Graph *g, int *colors, int k) {
+
+        int *counts, u, i, c, best;
+
+        counts = malloc((k + 1) * sizeof(int));
+        if (!counts) ALLOCATION_ERROR();
+
+        for (u = 0; u < g->n; u++) {
+                if (colors[u] >= 1 && colors[u] <= k) continue;
+
+                memset(counts, 0, (k + 1) * sizeof(int));
+                for (i = g->offsets[u]; i < g->offsets[u + 1]; i++) {
+                        c = colors[g->neighbors[i]];
+                        if (c >= 1 && c <= k) counts[c]++;
+                }
+
+                for (best = 1, c = 2; c <= k; c++) {
+                        if (counts[c] < counts[best]) best = c;
+                }
+                colors[u] = best;
+        }
+
+        free(counts);
+}
+
+/**
+ * Searches for a coloring of the graph with colors 1..k with no conflicting
+ * edges.
+ * @param Graph *g
+ *      Pointer to graph instance.
+ * @param int *colors
+ *      The color of each node to start from.  Colors outside 1..k are first
+ *      replaced.  On return, the coloring with the fewest conflicting edges
+ *      found.
+ * @param int k
+ *      The number of colors.
+ * @param long max_iterations
+ *      Iterations after which the search gives up.
+ * @param double deadline
+ *      Time, as given by stats_now(), after which the search gives up.
+ * @param Rng *rng
+ *      The random number generator breaking ties and drawing tenures.
+ * @return
+ *      The number of conflicting edges of the coloring returned, 0 if it is
+ *      valid.
+ */
+int
+tabucol(Graph *g, int *colors, int k, long max_iterations, double deadline,
+    Rng *rng) {
+
+        ConflictSet conflicting;
+        int *gamma;                     /* gamma[v * (k + 1) + i] is the
+                                           number of neighbors of v with
+                                           color i. */
+        long *tabu;                     /* tabu[v * (k + 1) + i] is the
+                                           iteration until which moving v to
+                                           i is tabu. */
+        int *best;
+        int *row, u, v, i, c, old, f, best_f, delta, best_delta, nBest,
+            best_u = 0, best_c = 0;
+        long it;
+
+        assert(g != NULL);
+        assert(colors != NULL);
+        assert(k >= 1);
+
+        tabucol_squeeze(g, colors, k);
+
+        gamma = calloc((size_t) g->n * (k + 1), sizeof(int));
+        tabu = calloc((size_t) g->n * (k + 1), sizeof(long));
+        best = malloc(g->n * sizeof(int));
+        conflicting.nodes = malloc(g->n * sizeof(int));
+        conflicting.pos = malloc(g->n * sizeof(int));
+        if (!gamma || !tabu || !best || !conflicting.nodes ||
+            !conflicting.pos)
+                ALLOCATION_ERROR();
+
+        for (u = 0; u < g->n; u++) {
+                for (i = g->offsets[u]; i < g->offsets[u + 1]; i++) {
+                        gamma[(size_t) u * (k + 1) +
+                                colors[g->neighbors[i]]]++;
+                }
+        }
+
+        f = 0;
+        conflicting.size = 0;
+        for (u = 0; u < g->n; u++) {
+                conflicting.pos[u] = -1;
+                c = gamma[(size_t) u * (k + 1) + colors[u]];
+                conflict_set_update(&conflicting, u, c);
+                f += c;
+        }
+        f /= 2;
+
+        best_f = f;
+        memcpy(best, colors, g->n * sizeof(int));
+
+        for (it = 0; f > 0 && it < max_iterations; it++) {
+
+                /* Reading the clock is slow next to an iteration. */
+                if (it % 1024 == 0 && stats_now() >= deadline) break;
+
+                /* Find the best move, breaking ties at random. */
+                best_delta = INT_MAX;
+                nBest = 0;
+                for (i = 0; i < conflicting.size; i++) {
+                        u = conflicting.nodes[i];
+                        row = &gamma[(size_t) u * (k + 1)];
+                        for (c = 1; c <= k; c++) {
+                                if (c == colors[u]) continue;
+
+                                delta = row[c] - row[colors[u]];
+                                if (tabu[(size_t) u * (k + 1) + c] > it &&
+                                    f + delta >= best_f)
+                                        continue;
+
+                                if (delta < best_delta) {
+                                        best_delta = delta;
+                                        nBest = 1;
+                                        best_u = u;
+                                        best_c = c;
+                                } else if (delta == best_delta &&
+                                    rng_below(rng, ++nBest) == 0) {
+                                        best_u = u;
+                                        best_c = c;
+                                }
+                        }
+                }
+                stats.moves_proposed += (long) conflicting.size * (k - 1);
+
+                /* Every move is tabu; wait for one to be released. */
+                if (!nBest) continue;
+
+                old = colors[best_u];
+                colors[best_u] = best_c;
+                f += best_delta;
+                stats.moves_accepted++;
+
+                for (i = g->offsets[best_u]; i < g->offsets[best_u + 1]; i++) {
+                        v = g->neighbors[i];
+                        row = &gamma[(size_t) v * (k + 1)];
+                        row[old]--;
+                        row[best_c]++;
+                        conflict_set_update(&conflicting, v, row[colors[v]]);
+                }
+                conflict_set_update(&conflicting, best_u,
+                                gamma[(size_t) best_u * (k + 1) + best_c]);
+
+                tabu[(size_t) best_u * (k + 1) + old] = it + 1 +
+                        rng_below(rng, TABUCOL_TENURE) +
+                        (long) (TABUCOL_TENURE_FACTOR * conflicting.size);
+
+                if (f < best_f) {
+                        best_f = f;
+                        memcpy(best, colors, g->n * sizeof(int));
+                }
+        }
+
+        DEBUG_PRINT("Tabucol: %d conflicts with %d colors after %ld "
+                        "iterations", best_f, k, it);
+
+        memcpy(colors, best, g->n * sizeof(int));
+
+        free(gamma);
+        free(tabu);
+        free(best);
+        free(conflicting.nodes);
+        free(conflicting.pos);
+
+        return best_f;
+}
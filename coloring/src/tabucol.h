@@ -0,0 +1,19 @@
+/*
+ * Module defining Tabucol, a tabu search for a coloring of a graph with a
+ * fixed number of colors and no conflicting edges.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef TABUCOL_H
+#define TABUCOL_H
+
+#include "graph.h"
+#include "rng.h"
+
+/*
+ * Iterations after which Tabucol gives up on finding a valid coloring.
+ */
+#define TABUCOL_MAX_ITERATIONS 1000000
+
+int tabucol(Graph *, int *, int, long, double, Rng *);
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Microbenchmark comparing the generic PQueue, which stores void pointers
+ * and computes priorities through a function pointer, with the typed 4-ary
+ * heap generated by DHEAP_DEFINE.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dheap.h"
+#include "pqueue.h"
+
+/*
+ * Payload resembling a node of the branch and bound solution tree.
+ */
+typedef struct {
+        double bound;
+        int value;
+        int weight;
+        int level;
+} BenchNode;
+
+DHEAP_DEFINE(BenchHeap, BenchNode *)
+
+/* Number of times each measurement is repeated, the best time is kept. */
+#define REPEATS 5
+
+static double
+bench_node_get_bound(void *x) {
+        return ((BenchNode *) x)->bound;
+}
+
+static double
+now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Fills n enqueues then n dequeues on the generic queue, followed by n
+ * dequeue/enqueue pairs at size n.  Returns nanoseconds per operation.
+ */
+static double
+bench_pqueue(BenchNode *nodes, int n) {
+
+        PQueue *pq;
+        void *x;
+        double start;
+        int i;
+
+        pq = pqueue_init(n, bench_node_get_bound);
+        start = now();
+
+        for (i = 0; i < n; i++) pqueue_enqueue(pq, &nodes[i]);
+        for (i = 0; i < n; i++) {
+                pqueue_dequeue(pq, &x, NULL);
+                pqueue_enqueue(pq, x);
+        }
+        for (i = 0; i < n; i++) pqueue_dequeue(pq, &x, NULL);
+
+        start = now() - start;
+        pqueue_free(pq);
+        free(pq);
+
+        return start * 1e9 / (4.0 * n);
+}
+
+/**
+ * As bench_pqueue, on the typed 4-ary heap.
+ */
+static double
+bench_dheap(BenchNode *nodes, int n) {
+
+        BenchHeap h;
+        BenchNode *x;
+        double start;
+        int i;
+
+        BenchHeap_init(&h, n);
+        start = now();
+
+        for (i = 0; i < n; i++) BenchHeap_push(&h, &nodes[i], nodes[i].bound);
+        for (i = 0; i < n; i++) {
+                x = BenchHeap_pop(&h, NULL);
+                BenchHeap_push(&h, x, x->bound);
+        }
+        for (i = 0; i < n; i++) BenchHeap_pop(&h, NULL);
+
+        start = now() - start;
+        BenchHeap_free(&h);
+
+        return start * 1e9 / (4.0 * n);
+}
+
+int
+main(int argc, char **argv) {
+
+        BenchNode *nodes;
+        double t_pqueue, t_dheap, t;
+        int sizes[] = {1000, 10000, 100000, 1000000, 4000000};
+        int i, r, n;
+
+        printf("%10s %14s %14s %9s\n", "elements", "pqueue ns/op",
+                        "dheap ns/op", "speedup");
+
+        for (i = 0; i < (int) (sizeof(sizes) / sizeof(int)); i++) {
+                n = sizes[i];
+                nodes = malloc(n * sizeof(BenchNode));
+                if (!nodes) return 1;
+
+                srand(n);
+                for (r = 0; r < n; r++) {
+                        memset(&nodes[r], 0, sizeof(BenchNode));
+                        nodes[r].bound = (double) rand() / RAND_MAX * 1e6;
+                }
+
+                t_pqueue = t_dheap = 1e30;
+                for (r = 0; r < REPEATS; r++) {
+                        t = bench_pqueue(nodes, n);
+                        if (t < t_pqueue) t_pqueue = t;
+                        t = bench_dheap(nodes, n);
+                        if (t < t_dheap) t_dheap = t;
+                }
+
+                printf("%10d %14.1f %14.1f %8.2fx\n", n, t_pqueue, t_dheap,
+                                t_pqueue / t_dheap);
+                free(nodes);
+        }
+
+        return 0;
+}
@@ -0,0 +1,300 @@
+/*
+ * Microbenchmark timing the inner kernels of the knapsack solver in
+ * isolation: priority queue operations on the open nodes of the branch and
+ * bound search, bound() and a dynamic programming row update.
+ *
+ * The solver modules holding static kernels are included directly so the
+ * benchmark calls the same code the solver runs.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pqueue.h"
+
+#include "../src/partition.c"
+#include "../src/solver.c"
+
+/*
+ * Least time (in seconds) over which each kernel is measured.  The number of
+ * operations is doubled until a run takes at least this long.
+ */
+#define MIN_SECONDS 0.2
+
+/*
+ * Signature of a benchmarked kernel: performs ops operations on the given
+ * context and returns the seconds elapsed.
+ */
+typedef double (*Kernel)(void *, long);
+
+/*
+ * Sink for results, so the compiler cannot discard the kernels' work.
+ */
+static volatile double sink;
+
+static double
+now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Times the given kernel and prints its cost per operation and throughput.
+ * @param const char *name
+ *      Name of the kernel.
+ * @param long size
+ *      Input size the context was built for.
+ * @param const char *unit
+ *      The unit of work reported.
+ * @param double per_op
+ *      Units of work done by one operation of the kernel.  Operations are
+ *      run in multiples of 64.
+ */
+static void
+measure(const char *name, long size, const char *unit, double per_op,
+    Kernel run, void *ctx) {
+
+        double t;
+        long ops = 64;
+
+        run(ctx, ops);
+        while ((t = run(ctx, ops)) < MIN_SECONDS) ops *= 2;
+
+        printf("%-22s %10ld %12.2f ns/%-5s %10.2f M%s/s\n", name, size,
+                        t * 1e9 / (ops * per_op), unit,
+                        ops * per_op / t / 1e6, unit);
+}
+
+/*
+ * Context of the priority queue kernels: a fixed population of nodes kept
+ * in the queue while one node at a time is dequeued and enqueued again.
+ */
+typedef struct {
+        Node *nodes;
+        PQueue *pq;
+        NodeHeap heap;
+        int n;
+} HeapBench;
+
+static void
+heap_bench_init(HeapBench *b, int n) {
+
+        int i;
+
+        b->n = n;
+        b->nodes = calloc(n, sizeof(Node));
+        if (!b->nodes) ALLOCATION_ERROR();
+
+        for (i = 0; i < n; i++)
+                b->nodes[i].bound = (double) rand() / RAND_MAX * 1e6;
+
+        b->pq = pqueue_init(n, node_get_bound);
+        NodeHeap_init(&b->heap, n);
+        for (i = 0; i < n; i++) {
+                pqueue_enqueue(b->pq, &b->nodes[i]);
+                NodeHeap_push(&b->heap, &b->nodes[i], b->nodes[i].bound);
+        }
+}
+
+static void
+heap_bench_free(HeapBench *b) {
+        pqueue_free(b->pq);
+        free(b->pq);
+        NodeHeap_free(&b->heap);
+        free(b->nodes);
+}
+
+/**
+ * Dequeues the top node and enqueues it with a new, lower, bound, as the
+ * search does when replacing a node by its children.  One operation is a
+ * dequeue and an enqueue.
+ */
+static double
+run_pqueue(void *x, long ops) {
+
+        HeapBench *b = x;
+        Node *u;
+        void *data;
+        double start = now();
+        long i;
+
+        for (i = 0; i < ops; i++) {
+                pqueue_dequeue(b->pq, &data, NULL);
+                u = data;
+                u->bound *= 0.999;
+                pqueue_enqueue(b->pq, u);
+        }
+
+        return now() - start;
+}
+
+static double
+run_dheap(void *x, long ops) {
+
+        HeapBench *b = x;
+        Node *u;
+        double start = now();
+        long i;
+
+        for (i = 0; i < ops; i++) {
+                u = NodeHeap_pop(&b->heap, NULL);
+                u->bound *= 0.999;
+                NodeHeap_push(&b->heap, u, u->bound);
+        }
+
+        return now() - start;
+}
+
+/*
+ * Context of the bound() kernel: items sorted by density and nodes at
+ * random levels of the solution tree.
+ */
+typedef struct {
+        Item *items;
+        Node *nodes;
+        int n, K, nNodes;
+} BoundBench;
+
+static void
+bound_bench_init(BoundBench *b, int n) {
+
+        long total = 0;
+        int i;
+
+        b->n = n;
+        b->nNodes = 1024;
+        b->items = malloc(n * sizeof(Item));
+        b->nodes = calloc(b->nNodes, sizeof(Node));
+        if (!b->items || !b->nodes) ALLOCATION_ERROR();
+
+        for (i = 0; i < n; i++) {
+                b->items[i].id = i;
+                b->items[i].weight = 1 + rand() % 1000;
+                b->items[i].value = 1 + rand() % 1000;
+                total += b->items[i].weight;
+        }
+        qsort(b->items, n, sizeof(Item), item_density_comp);
+        b->K = (int) (total / 2);
+
+        /* Nodes high in the tree have most of the capacity left. */
+        for (i = 0; i < b->nNodes; i++) {
+                b->nodes[i].level = rand() % n - 1;
+                b->nodes[i].weight = (int) ((double) rand() / RAND_MAX *
+                                b->K * (b->nodes[i].level + 1) / n);
+        }
+}
+
+static void
+bound_bench_free(BoundBench *b) {
+        free(b->items);
+        free(b->nodes);
+}
+
+static double
+run_bound(void *x, long ops) {
+
+        BoundBench *b = x;
+        double start = now(), sum = 0;
+        long i;
+
+        for (i = 0; i < ops; i++)
+                sum += bound(b->n, b->K, b->items,
+                                &b->nodes[i & (b->nNodes - 1)]);
+
+        sink = sum;
+        return now() - start;
+}
+
+/*
+ * Context of the dynamic programming kernel: a row of capacity c and items
+ * applied to it one at a time.
+ */
+typedef struct {
+        Item items[64];
+        int *P;
+        int c;
+        double cells;           /* Mean number of cells updated per item. */
+} RowBench;
+
+static void
+row_bench_init(RowBench *b, int c) {
+
+        int i;
+
+        b->c = c;
+        b->P = calloc(c + 1, sizeof(int));
+        if (!b->P) ALLOCATION_ERROR();
+
+        b->cells = 0;
+        for (i = 0; i < 64; i++) {
+                b->items[i].weight = 1 + rand() % 1000;
+                b->items[i].value = 1 + rand() % 1000;
+                b->cells += (c - b->items[i].weight + 1) / 64.0;
+        }
+}
+
+/**
+ * Applies ops items to the row.  Each call of profile_extend on one item is
+ * the row update of the solver's dynamic programs.  The row is cleared,
+ * untimed, before every 64 items, so its values stay those of a 64 item
+ * instance rather than growing without bound over the passes.
+ */
+static double
+run_row(void *x, long ops) {
+
+        RowBench *b = x;
+        double start, t = 0;
+        long i;
+
+        for (i = 0; i < ops; i++) {
+                if ((i & 63) == 0) {
+                        memset(b->P, 0, (b->c + 1) * sizeof(int));
+                        start = now();
+                }
+                profile_extend(b->items, i & 63, (i & 63) + 1, b->c, b->P);
+                if ((i & 63) == 63) t += now() - start;
+        }
+
+        return t;
+}
+
+int
+main(int argc, char **argv) {
+
+        int heap_sizes[] = {1000, 10000, 100000, 1000000};
+        int bound_sizes[] = {100, 1000, 10000, 100000};
+        int row_sizes[] = {1000, 10000, 100000, 1000000, 10000000};
+        HeapBench hb;
+        BoundBench bb;
+        RowBench rb;
+        int i;
+
+        srand(1);
+
+        printf("%-22s %10s %15s %17s\n", "kernel", "size", "cost",
+                        "throughput");
+
+        for (i = 0; i < (int) (sizeof(heap_sizes) / sizeof(int)); i++) {
+                heap_bench_init(&hb, heap_sizes[i]);
+                measure("pqueue deq+enq", hb.n, "op", 1, run_pqueue, &hb);
+                measure("NodeHeap pop+push", hb.n, "op", 1, run_dheap, &hb);
+                heap_bench_free(&hb);
+        }
+
+        for (i = 0; i < (int) (sizeof(bound_sizes) / sizeof(int)); i++) {
+                bound_bench_init(&bb, bound_sizes[i]);
+                measure("bound", bb.n, "call", 1, run_bound, &bb);
+                bound_bench_free(&bb);
+        }
+
+        for (i = 0; i < (int) (sizeof(row_sizes) / sizeof(int)); i++) {
+                row_bench_init(&rb, row_sizes[i]);
+                measure("dp row update", rb.c, "cell", rb.cells, run_row, &rb);
+                free(rb.P);
+        }
+
+        return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * Module implementing a per-level table of the nodes of the branch and bound
+ * solution tree which are not dominated by another node.
+ *
+ * A node at level l with weight w and value v is dominated by another node
+ * at the same level with weight w' <= w and value v' >= v: every completion
+ * of the former is also a completion of the latter, worth at least as much.
+ * For each level the table holds the Pareto frontier of the pairs seen,
+ * sorted by weight, so the best value of any pair no heavier than w is
+ * that of the last entry with weight <= w.
+ *
+ * The table may be limited to a number of entries, shared evenly by the
+ * levels.  A full level evicts a random entry to record a new one, so the
+ * table prunes less but never wrongly: a node is reported dominated only
+ * if a recorded entry dominates it, so a node whose entry was evicted is
+ * kept.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dominance.h"
+#include "utils.h"
+
+/**
+ * Constant defining the number of entries initially allocated for a level.
+ */
+#define MIN_LEVEL_SIZE 16
+
+/**
+ * Initializes and returns pointer to an empty table with the given number of
+ * levels.
+ * @param int n
+ *      The number of levels.
+ * @param size_t max_entries
+ *      The most entries allocated over all levels, 0 for no limit.
+ */
+DominanceTable *
+dominance_init(int n, size_t max_entries) {
+
+        DominanceTable *t;
+
+        t = malloc(sizeof(DominanceTable));
+        if (!t) ALLOCATION_ERROR();
+
+        t->n = n;
+        t->max_level = 0;
+        if (max_entries) {
+                t->max_level = max_entries / (n > 0 ? n : 1);
+                if (t->max_level < MIN_LEVEL_SIZE)
+                        t->max_level = MIN_LEVEL_SIZE;
+        }
+        t->rng = 0x9e3779b97f4a7c15ULL;
+        t->entries = calloc(n > 0 ? n : 1, sizeof(DominanceEntry *));
+        t->count = calloc(n > 0 ? n : 1, sizeof(int));
+        t->sz = calloc(n > 0 ? n : 1, sizeof(int));
+        if (!t->entries || !t->count || !t->sz) ALLOCATION_ERROR();
+
+        return t;
+}
+
+/**
+ * Returns the index of the last entry of the level with weight <= w, or -1 if
+ * there is none.
+ */
+static int
+predecessor(DominanceEntry *e, int count, int w) {
+
+        int lo = 0, hi = count, mid;
+
+        while (lo < hi) {
+                mid = lo + (hi - lo) / 2;
+                if (e[mid].weight <= w) lo = mid + 1;
+                else hi = mid;
+        }
+        return lo - 1;
+}
+
+/**
+ * Records a node with the given weight and value at the given level unless
+ * it is dominated by (or equal to) a node already recorded.  Entries the new
+ * node dominates are removed.  If the level is full and the node dominates
+ * no entry, a random entry is evicted to make room.
+ * @return
+ *      1 if the node was recorded, 0 if it is dominated and may be discarded.
+ */
+int
+dominance_insert(DominanceTable *t, int level, int weight, int value) {
+
+        DominanceEntry *e, *tmp;
+        int i, j, k;
+
+        assert(level >= 0 && level < t->n);
+
+        e = t->entries[level];
+        i = predecessor(e, t->count[level], weight);
+        if (i >= 0 && e[i].value >= value) return 0;
+
+        /* Entries from i + 1 on are heavier; drop those worth no more. */
+        for (j = i + 1; j < t->count[level] && e[j].value <= value; j++)
+                ;
+
+        if (j == i + 1 && t->max_level &&
+            t->count[level] == t->max_level) {
+                /* Evict a random entry, by xorshift. */
+                t->rng ^= t->rng << 13;
+                t->rng ^= t->rng >> 7;
+                t->rng ^= t->rng << 17;
+                k = (int) (t->rng % t->count[level]);
+
+                memmove(&e[k], &e[k + 1], (t->count[level] - k - 1) *
+                                sizeof(DominanceEntry));
+                t->count[level]--;
+                if (k <= i) i--;
+                j = i + 1;
+        } else if (j == i + 1 && t->count[level] == t->sz[level]) {
+                t->sz[level] = t->sz[level] ? 2 * t->sz[level] :
+                        MIN_LEVEL_SIZE;
+                if (t->max_level && t->sz[level] > t->max_level)
+                        t->sz[level] = t->max_level;
+                tmp = realloc(e, t->sz[level] * sizeof(DominanceEntry));
+                if (!tmp) ALLOCATION_ERROR();
+                e = t->entries[level] = tmp;
+        }
+
+        /* Slide the remaining heavier entries to just after the new one. */
+        memmove(&e[i + 2], &e[j], (t->count[level] - j) *
+                        sizeof(DominanceEntry));
+        t->count[level] -= j - (i + 1) - 1;
+
+        e[i + 1].weight = weight;
+        e[i + 1].value = value;
+
+        return 1;
+}
+
+/**
+ * Returns 1 if a node with the given weight and value admitted at the given
+ * level has not since been dominated by a node recorded after it, 0
+ * otherwise.  The entry no heavier than the node with the highest value is
+ * either the node's own or, if it is worth at least as much, one which
+ * dominates it.
+ */
+int
+dominance_is_current(DominanceTable *t, int level, int weight, int value) {
+
+        DominanceEntry *e = t->entries[level];
+        int i;
+
+        i = predecessor(e, t->count[level], weight);
+        return i < 0 || e[i].value < value ||
+                (e[i].weight == weight && e[i].value == value);
+}
+
+/**
+ * Free memory associated with the given table.
+ */
+void
+dominance_free(DominanceTable *t) {
+
+        int i;
+
+        if (!t) return;
+        for (i = 0; i < t->n; i++) {
+                free(t->entries[i]);
+        }
+        free(t->entries);
+        free(t->count);
+        free(t->sz);
+        free(t);
+}
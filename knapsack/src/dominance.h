@@ -0,0 +1,51 @@
+/*
+ * Module defining a per-level table of the nodes of the branch and bound
+ * solution tree which are not dominated by another node.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef DOMINANCE_H
+#define DOMINANCE_H
+
+#include <stddef.h>
+
+typedef struct {
+        int weight;
+        int value;
+} DominanceEntry;
+
+typedef struct {
+        /**
+         * For each level, the non-dominated (weight, value) pairs seen at
+         * that level in increasing order of weight (and thus of value).
+         */
+        DominanceEntry **entries;
+
+        /** The number of entries held for each level. */
+        int *count;
+
+        /** The number of entries allocated for each level. */
+        int *sz;
+
+        /** The number of levels in the table. */
+        int n;
+
+        /** The most entries held for a level, 0 for no limit. */
+        int max_level;
+
+        /** State of the generator choosing entries to evict. */
+        unsigned long long rng;
+} DominanceTable;
+
+DominanceTable *
+dominance_init(int, size_t);
+
+int
+dominance_insert(DominanceTable *, int, int, int);
+
+int
+dominance_is_current(DominanceTable *, int, int, int);
+
+void
+dominance_free(DominanceTable *);
+
+#endif
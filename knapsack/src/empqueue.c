@@ -0,0 +1,385 @@
+/*
+ * Module implementing an external memory max priority queue in the C
+ * programming language.  Records are copied into the queue by value.
+ *
+ * The highest priority records are kept in RAM in a binary heap of bounded
+ * size.  When the heap fills it is sorted, the upper half is kept (a sorted
+ * array is a valid heap) and the lower half is written to disk as a run in
+ * decreasing order of priority.  Runs are memory-mapped and consumed from
+ * their front, so the next record to be dequeued is the best of the heap's
+ * root and the front of each run.  Runs are merged level by level: a spilled
+ * run is of level 0, and once the newest EMPQUEUE_MERGE_WIDTH runs are of
+ * the same level they are merged into one run of the next level.  A record
+ * is thus rewritten once per level, a logarithmic number of times, rather
+ * than on every merge.  Run files are unlinked as soon as they are created
+ * so they never outlive the process.
+ * Marko Tomislav Babic - mbabic
+ */
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "empqueue.h"
+
+/**
+ * Prints message indicating a failure of the given operation and exits.
+ */
+static void
+empqueue_error(const char *op) {
+        perror(op);
+        fprintf(stderr, "External memory queue failure.\n %s: %d\n", __FILE__,
+                        __LINE__);
+        exit(1);
+}
+
+/* Returns pointer to the priority of the i_th record of the given array. */
+#define PRIORITY(pq, base, i) ((double *) ((base) + (i) * (pq)->stride))
+
+/* Returns pointer to the bytes of the i_th record of the given array. */
+#define RECORD(pq, base, i) ((base) + (i) * (pq)->stride + sizeof(double))
+
+/**
+ * Initializes and returns pointer to an empty external memory queue.
+ * @param size_t elem_size
+ *      Size in bytes of the records to be stored.
+ * @param size_t max_head
+ *      Max number of records to be held in RAM.
+ * @param const char *dir
+ *      Directory in which to create run files.  If NULL, $TMPDIR or /tmp is
+ *      used.
+ */
+EMPQueue *
+empqueue_init(size_t elem_size, size_t max_head, const char *dir) {
+
+        EMPQueue *pq;
+
+        pq = malloc(sizeof(EMPQueue));
+        if (!pq) empqueue_error("malloc");
+
+        if (!dir) dir = getenv("TMPDIR");
+        if (!dir) dir = "/tmp";
+
+        pq->elemSize = elem_size;
+        pq->stride = sizeof(double) + elem_size;
+        /* Round up so priorities stay aligned. */
+        pq->stride = (pq->stride + sizeof(double) - 1) / sizeof(double) *
+                sizeof(double);
+        pq->maxHead = max_head < 2 ? 2 : max_head;
+        pq->nHead = 0;
+        pq->nRuns = 0;
+        pq->maxRuns = EMPQUEUE_MERGE_WIDTH;
+        pq->nSpilled = 0;
+        pq->nSpills = 0;
+        pq->bytesWritten = 0;
+        snprintf(pq->dir, sizeof(pq->dir), "%s", dir);
+
+        pq->head = malloc(pq->maxHead * pq->stride);
+        if (!pq->head) empqueue_error("malloc");
+
+        pq->runs = malloc(pq->maxRuns * sizeof(EMPQueueRun));
+        if (!pq->runs) empqueue_error("malloc");
+
+        return pq;
+}
+
+/* Qsort comparison function ordering records by decreasing priority. */
+static int
+record_comp(const void *a, const void *b) {
+        double x = *(const double *) a;
+        double y = *(const double *) b;
+        if (x > y) return -1;
+        else if (y > x) return 1;
+        return 0;
+}
+
+/**
+ * Creates an unlinked file in the queue's directory and returns its
+ * descriptor.
+ */
+static int
+run_file_create(EMPQueue *pq) {
+
+        char path[512];
+        int fd;
+
+        snprintf(path, sizeof(path), "%s/empqueue.XXXXXX", pq->dir);
+        fd = mkstemp(path);
+        if (fd < 0) empqueue_error("mkstemp");
+        unlink(path);
+
+        return fd;
+}
+
+/**
+ * Writes len bytes of buf to the given file, retrying on partial writes.
+ */
+static void
+write_all(int fd, const char *buf, size_t len) {
+
+        ssize_t written;
+
+        while (len > 0) {
+                written = write(fd, buf, len);
+                if (written < 0) empqueue_error("write");
+                buf += written;
+                len -= written;
+        }
+}
+
+/**
+ * Maps the given file, holding count records, as the newest run, of the
+ * given level.
+ */
+static void
+run_map(EMPQueue *pq, int fd, size_t count, int level) {
+
+        EMPQueueRun *run;
+
+        if (pq->nRuns == pq->maxRuns) {
+                pq->maxRuns *= 2;
+                pq->runs = realloc(pq->runs, pq->maxRuns *
+                                sizeof(EMPQueueRun));
+                if (!pq->runs) empqueue_error("realloc");
+        }
+
+        run = &pq->runs[pq->nRuns++];
+        run->len = count * pq->stride;
+        run->count = count;
+        run->pos = 0;
+        run->released = 0;
+        run->level = level;
+        run->map = mmap(NULL, run->len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (run->map == MAP_FAILED) empqueue_error("mmap");
+
+        /* Records are consumed from the front of the run. */
+        madvise(run->map, run->len, MADV_SEQUENTIAL);
+        close(fd);
+}
+
+static void
+run_unmap(EMPQueueRun *run) {
+        munmap(run->map, run->len);
+}
+
+/**
+ * Writes the records left in the runs from the given one to the newest to a
+ * single new run, in decreasing order of priority, which replaces them.
+ */
+static void
+runs_merge(EMPQueue *pq, int first) {
+
+        FILE *out;
+        EMPQueueRun *run;
+        size_t count = 0;
+        int fd, i, best, level = pq->runs[first].level + 1;
+
+        fd = run_file_create(pq);
+        out = fdopen(fd, "w+");
+        if (!out) empqueue_error("fdopen");
+
+        for (;;) {
+                best = -1;
+                for (i = first; i < pq->nRuns; i++) {
+                        run = &pq->runs[i];
+                        if (run->pos < run->count && (best < 0 ||
+                            *PRIORITY(pq, run->map, run->pos) >
+                            *PRIORITY(pq, pq->runs[best].map,
+                                    pq->runs[best].pos)))
+                                best = i;
+                }
+                if (best < 0) break;
+
+                run = &pq->runs[best];
+                if (fwrite(PRIORITY(pq, run->map, run->pos), pq->stride, 1,
+                    out) != 1)
+                        empqueue_error("fwrite");
+                run->pos++;
+                count++;
+        }
+
+        if (fflush(out) != 0) empqueue_error("fflush");
+        pq->bytesWritten += count * pq->stride;
+
+        for (i = first; i < pq->nRuns; i++) {
+                run_unmap(&pq->runs[i]);
+        }
+        pq->nRuns = first;
+
+        fd = dup(fileno(out));
+        fclose(out);
+        if (count > 0) run_map(pq, fd, count, level);
+        else close(fd);
+}
+
+/**
+ * Sorts the head, keeps its upper half in RAM and writes the lower half to
+ * disk as a new run.
+ */
+static void
+empqueue_spill(EMPQueue *pq) {
+
+        size_t keep = pq->nHead / 2, count = pq->nHead - keep;
+        int fd, first;
+
+        qsort(pq->head, pq->nHead, pq->stride, record_comp);
+
+        fd = run_file_create(pq);
+        write_all(fd, (char *) PRIORITY(pq, pq->head, keep),
+                        count * pq->stride);
+
+        run_map(pq, fd, count, 0);
+        pq->nHead = keep;
+        pq->nSpilled += count;
+        pq->nSpills++;
+        pq->bytesWritten += count * pq->stride;
+
+        /* Levels never increase from the oldest run to the newest. */
+        while ((first = pq->nRuns - EMPQUEUE_MERGE_WIDTH) >= 0 &&
+            pq->runs[first].level == pq->runs[pq->nRuns - 1].level)
+                runs_merge(pq, first);
+}
+
+/**
+ * Adds a copy of the given record to the queue with the given priority.
+ */
+void
+empqueue_enqueue(EMPQueue *pq, void *data, double priority) {
+
+        size_t k, level;
+
+        if (pq->nHead == pq->maxHead) empqueue_spill(pq);
+
+        /* Bubble new record up the heap into correct position. */
+        k = pq->nHead++;
+        while (k > 0 && priority > *PRIORITY(pq, pq->head, level = (k - 1) / 2)) {
+                memcpy(PRIORITY(pq, pq->head, k), PRIORITY(pq, pq->head, level),
+                                pq->stride);
+                k = level;
+        }
+        *PRIORITY(pq, pq->head, k) = priority;
+        memcpy(RECORD(pq, pq->head, k), data, pq->elemSize);
+}
+
+/**
+ * Removes the root of the in memory heap.
+ */
+static void
+head_pop(EMPQueue *pq) {
+
+        size_t k = 0, child, last;
+
+        last = --pq->nHead;
+        while ((child = 2 * k + 1) < last) {
+                if (child + 1 < last && *PRIORITY(pq, pq->head, child) <
+                    *PRIORITY(pq, pq->head, child + 1))
+                        child++;
+
+                if (*PRIORITY(pq, pq->head, last) >=
+                    *PRIORITY(pq, pq->head, child))
+                        break;
+
+                memcpy(PRIORITY(pq, pq->head, k), PRIORITY(pq, pq->head, child),
+                                pq->stride);
+                k = child;
+        }
+        if (k != last)
+                memcpy(PRIORITY(pq, pq->head, k), PRIORITY(pq, pq->head, last),
+                                pq->stride);
+}
+
+/**
+ * Removes the highest priority record from the queue.
+ * @param void *data
+ *      Buffer of at least the record size into which the record is copied.
+ * @param double *priority
+ *      If not NULL, pointer into which the record's priority is stored.
+ *
+ * @return
+ *      1 if a record was dequeued, 0 if the queue was empty.
+ */
+int
+empqueue_dequeue(EMPQueue *pq, void *data, double *priority) {
+
+        EMPQueueRun *run;
+        double best;
+        int i, best_run = -1;
+
+        best = pq->nHead > 0 ? *PRIORITY(pq, pq->head, 0) : 0;
+        for (i = 0; i < pq->nRuns; i++) {
+                run = &pq->runs[i];
+                if (run->pos < run->count && ((pq->nHead == 0 && best_run < 0)
+                    || *PRIORITY(pq, run->map, run->pos) > best)) {
+                        best = *PRIORITY(pq, run->map, run->pos);
+                        best_run = i;
+                }
+        }
+
+        if (best_run < 0 && pq->nHead == 0) return 0;
+
+        if (priority) *priority = best;
+
+        if (best_run < 0) {
+                memcpy(data, RECORD(pq, pq->head, 0), pq->elemSize);
+                head_pop(pq);
+                return 1;
+        }
+
+        run = &pq->runs[best_run];
+        memcpy(data, RECORD(pq, run->map, run->pos), pq->elemSize);
+        run->pos++;
+
+        /*
+         * Runs of high levels live long, so drop the pages already consumed
+         * rather than keep them resident until the run is unmapped.
+         */
+        if (run->pos * pq->stride - run->released >= EMPQUEUE_RELEASE_BYTES) {
+                madvise(run->map + run->released, EMPQUEUE_RELEASE_BYTES,
+                                MADV_DONTNEED);
+                run->released += EMPQUEUE_RELEASE_BYTES;
+        }
+
+        /* Removing the run keeps the others in the order written. */
+        if (run->pos == run->count) {
+                run_unmap(run);
+                memmove(run, run + 1, (--pq->nRuns - best_run) *
+                                sizeof(EMPQueueRun));
+        }
+
+        return 1;
+}
+
+/**
+ * Returns the number of records in the queue.
+ */
+size_t
+empqueue_size(EMPQueue *pq) {
+
+        size_t size = pq->nHead;
+        int i;
+
+        for (i = 0; i < pq->nRuns; i++) {
+                size += pq->runs[i].count - pq->runs[i].pos;
+        }
+        return size;
+}
+
+/**
+ * Free memory and files associated with the given queue.
+ */
+void
+empqueue_free(EMPQueue *pq) {
+
+        int i;
+
+        if (!pq) return;
+        for (i = 0; i < pq->nRuns; i++) {
+                run_unmap(&pq->runs[i]);
+        }
+        free(pq->runs);
+        free(pq->head);
+        free(pq);
+}
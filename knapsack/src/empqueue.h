@@ -0,0 +1,94 @@
+/*
+ * Implementation of an external memory max priority queue in the C language.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef EMPQUEUE_H
+#define EMPQUEUE_H
+
+#include <stddef.h>
+
+/**
+ * Constant defining the number of runs of a level which are merged into one
+ * run of the next level.
+ */
+#define EMPQUEUE_MERGE_WIDTH 8
+
+/**
+ * Constant defining the size in bytes of the chunks in which the consumed
+ * front of a run is released from memory.  A multiple of the page size.
+ */
+#define EMPQUEUE_RELEASE_BYTES (1 << 20)
+
+typedef struct {
+        /** Read-only mapping of the run's file. */
+        char *map;
+
+        /** Number of bytes mapped. */
+        size_t len;
+
+        /** Number of records in the run. */
+        size_t count;
+
+        /** Index of the next record to be dequeued from the run. */
+        size_t pos;
+
+        /** Number of bytes at the front of the mapping released. */
+        size_t released;
+
+        /** Number of merges the run's records went through. */
+        int level;
+} EMPQueueRun;
+
+typedef struct {
+        /**
+         * Heap of the highest priority records, each stored as its double
+         * priority followed by the record's bytes.
+         */
+        char *head;
+
+        /** Number of records currently in the head. */
+        size_t nHead;
+
+        /** Max number of records held in the head before spilling. */
+        size_t maxHead;
+
+        /** Size of a record in bytes. */
+        size_t elemSize;
+
+        /** Size of a record and its priority in bytes. */
+        size_t stride;
+
+        /**
+         * Runs of lower priority records spilled to disk, in the order they
+         * were written.
+         */
+        EMPQueueRun *runs;
+
+        /** The number of runs on disk, and of runs allocated. */
+        int nRuns;
+        int maxRuns;
+
+        /** Directory in which run files are created. */
+        char dir[256];
+
+        /** Number of records spilled to disk over the queue's life. */
+        size_t nSpilled;
+
+        /** Number of runs spilled from the head over the queue's life. */
+        size_t nSpills;
+
+        /** Number of bytes written to disk by spills and merges. */
+        size_t bytesWritten;
+} EMPQueue;
+
+EMPQueue *empqueue_init(size_t, size_t, const char *);
+
+void empqueue_enqueue(EMPQueue *, void *, double);
+
+int empqueue_dequeue(EMPQueue *, void *, double *);
+
+size_t empqueue_size(EMPQueue *);
+
+void empqueue_free(EMPQueue *);
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * Module implementing a fully polynomial time approximation scheme for the
+ * knapsack problem by value scaling.
+ *
+ * Let vmax be the largest value of an item which fits in the knapsack and
+ * mu = epsilon * vmax / n.  Each value is scaled down to floor(v / mu) and
+ * the scaled instance is solved exactly by a dynamic program over values,
+ * where W[p] is the least weight achieving scaled value p.  Rounding loses
+ * less than mu per item, so the solution found is worth at least
+ * OPT - n * mu >= (1 - epsilon) * OPT, in time O(n^3 / epsilon) regardless
+ * of the capacity of the knapsack.  Scaled values beyond the linear
+ * relaxation bound cannot be reached, so the rows of the program are cut off
+ * there.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fptas.h"
+#include "item.h"
+#include "solver.h"
+#include "stats.h"
+#include "utils.h"
+
+/* Qsort comparison function ordering items by decreasing value density. */
+static int
+density_comp(const void *a, const void *b) {
+        const Item *x = (const Item *) a;
+        const Item *y = (const Item *) b;
+        double dx = (double) x->value * y->weight;
+        double dy = (double) y->value * x->weight;
+        if (dx > dy) return -1;
+        else if (dy > dx) return 1;
+        return 0;
+}
+
+/**
+ * Returns the value of the linear relaxation of the instance (Dantzig's
+ * bound), found by greedily filling the knapsack by value density and
+ * taking a fraction of the first item which does not fit.
+ */
+static double
+relaxation_bound(int n, int K, Item *items) {
+
+        Item *sorted;
+        double bound = 0;
+        int i, remaining = K;
+
+        sorted = malloc((n > 0 ? n : 1) * sizeof(Item));
+        if (!sorted) ALLOCATION_ERROR();
+
+        memcpy(sorted, items, n * sizeof(Item));
+        qsort(sorted, n, sizeof(Item), density_comp);
+
+        for (i = 0; i < n && remaining > 0; i++) {
+                if (sorted[i].value <= 0) break;
+                if (sorted[i].weight <= remaining) {
+                        remaining -= sorted[i].weight;
+                        bound += sorted[i].value;
+                } else {
+                        bound += (double) remaining * sorted[i].value /
+                                sorted[i].weight;
+                        remaining = 0;
+                }
+        }
+
+        free(sorted);
+        return bound;
+}
+
+/**
+ * Solve instance of knapsack problem to within a factor of (1 - epsilon) of
+ * optimal.  The guarantee and an upper bound on the optimal value are
+ * reported on stderr.
+ * @param int n
+ *      The number of items to be considered.
+ * @param int K
+ *      The capacity of the knapsack.
+ * @param Item *items
+ *      Array of Item structs corresponding to the items to be placed in the
+ *      knapsack. 
+ * @param double epsilon
+ *      The largest fraction of the optimal value which may be lost,
+ *      0 < epsilon < 1.
+ *
+ * @return
+ *      String encoding solution.
+ */
+char *
+solve_knapsack_fptas(int n, int K, Item *items, double epsilon) {
+
+        unsigned char *taken, *row;
+        long long *W, candidate;
+        double mu, relax, upper, bytes = 0;
+        size_t *offset;
+        int *scaled, *reach, i, p, cap, vmax = 0, total = 0, best = 0,
+            value = 0;
+
+        assert(epsilon > 0 && epsilon < 1);
+
+        stats.solver = "fptas";
+
+        for (i = 0; i < n; i++) {
+                if (items[i].weight <= K && items[i].value > vmax)
+                        vmax = items[i].value;
+        }
+
+        /* 
+         * If the scaling factor is below 1 rounding gains nothing and the
+         * scaled instance is the original one.
+         */
+        mu = n > 0 ? epsilon * vmax / n : 1;
+        if (mu < 1) mu = 1;
+
+        scaled = malloc((n > 0 ? n : 1) * sizeof(int));
+        reach = malloc((n > 0 ? n : 1) * sizeof(int));
+        offset = malloc((n + 1) * sizeof(size_t));
+        if (!scaled || !reach || !offset) ALLOCATION_ERROR();
+
+        /* No solution is worth more than the scaled relaxation bound. */
+        relax = relaxation_bound(n, K, items);
+        cap = (int) (relax / mu);
+
+        /* 
+         * reach[i] bounds the scaled values reachable after item i, row i of
+         * the decision bit matrix covers values 0..reach[i].
+         */
+        offset[0] = 0;
+        for (i = 0; i < n; i++) {
+                if (items[i].weight > K || items[i].value <= 0)
+                        scaled[i] = 0;
+                else
+                        scaled[i] = (int) (items[i].value / mu);
+                total = total + scaled[i] < cap ? total + scaled[i] : cap;
+                reach[i] = total;
+                bytes += total / 8 + 1;
+                offset[i + 1] = offset[i] + (scaled[i] ? total / 8 + 1 : 0);
+        }
+
+        if (bytes > FPTAS_MAX_BYTES) {
+                fprintf(stderr, "FPTAS table would need %.0f bytes; use a "
+                                "larger epsilon.\n", bytes);
+                exit(1);
+        }
+
+        W = malloc(((size_t) total + 1) * sizeof(long long));
+        taken = calloc(offset[n] + 1, 1);
+        if (!W || !taken) ALLOCATION_ERROR();
+
+        W[0] = 0;
+        for (p = 1; p <= total; p++) W[p] = (long long) K + 1;
+
+        /* Populate row of least weights. */
+        for (i = 0; i < n; i++) {
+                if (scaled[i] == 0) continue;
+
+                row = taken + offset[i];
+                stats.dp_cells += reach[i] - scaled[i] + 1;
+                for (p = reach[i]; p >= scaled[i]; p--) {
+                        candidate = W[p - scaled[i]] + items[i].weight;
+                        if (candidate < W[p]) {
+                                W[p] = candidate;
+                                row[p >> 3] |= 1 << (p & 7);
+                        }
+                }
+        }
+
+        for (p = total; p > 0; p--) {
+                if (W[p] <= K) break;
+        }
+        best = p;
+
+        /* Construct solution by walking the recorded decisions backwards. */
+        for (i = n - 1; i >= 0; i--) {
+                row = taken + offset[i];
+                if (scaled[i] && (row[p >> 3] & (1 << (p & 7)))) {
+                        items[i].isTaken = 1;
+                        value += items[i].value;
+                        p -= scaled[i];
+                }
+        }
+
+        /*
+         * Each item of the optimal solution loses less than mu to rounding,
+         * so OPT < mu * (best + n).
+         */
+        upper = mu * ((double) best + n);
+        if (relax < upper) upper = relax;
+        if (value / (1 - epsilon) < upper) upper = value / (1 - epsilon);
+        if (mu == 1 || upper < value) upper = value;
+
+        fprintf(stderr, "FPTAS: epsilon = %g, value = %d >= (1 - epsilon) * "
+                        "OPT, OPT <= %lld\n", epsilon, value,
+                        (long long) upper);
+
+        free(taken);
+        free(W);
+        free(offset);
+        free(reach);
+        free(scaled);
+
+        return knapsack_solution_string(value, mu == 1, n, items);
+}
@@ -0,0 +1,20 @@
+/*
+ * Module defining a fully polynomial time approximation scheme for the
+ * knapsack problem.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef FPTAS_H
+#define FPTAS_H
+
+#include "item.h"
+
+/**
+ * Constant defining the largest decision bit matrix (in bytes) the
+ * approximation scheme will allocate.
+ */
+#define FPTAS_MAX_BYTES (1024UL * 1024 * 1024)
+
+char *
+solve_knapsack_fptas(int, int, Item *, double);
+
+#endif
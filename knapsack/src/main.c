@@ -1,26 +1,79 @@
+#include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "fptas.h"
 #include "item.h"
+#include "mitm.h"
+#include "node.h"
+#include "parser.h"
+#include "perf.h"
+#include "partition.h"
 #include "solver.h"
+#include "stats.h"
+#include "stream.h"
+#include "subset.h"
 #include "utils.h"
 
+/* 
+ * Define number of positional arguments expected from cmd line.
+ */
+#define NARGS 1
+
 /*
- * Define max length of line we will read from input file.
+ * Solvers which may be requested on the cmd line.
  */
-#define MAX_LINE_LENGTH 128
+typedef enum {
+        METHOD_AUTO,    /* Select the solver from the instance. */
+        METHOD_BB,      /* Branch and bound. */
+        METHOD_DP,      /* Dynamic programming. */
+        METHOD_MITM,    /* Meet in the middle. */
+        METHOD_SUBSET   /* Bitset subset sum. */
+} Method;
 
-/* 
- * Define number of arguments expected from cmd line.
+/*
+ * Structure holding the options given on the cmd line.
  */
-#define NARGS 2
+typedef struct {
+        /** Path to the input file. */
+        char *path;
+
+        /** The solver to be used. */
+        Method method;
+
+        /** Flag indicating the streaming solver is to be used. */
+        int stream;
+
+        /**
+         * Number of threads across which the items are partitioned.  0 if
+         * the item-partitioned solver is not to be used.
+         */
+        int threads;
+
+        /**
+         * Fraction of the optimal value the approximation scheme may lose.
+         * 0 if an exact solver is to be used.
+         */
+        double epsilon;
+
+        /**
+         * Megabytes of memory the branch and bound solver may use for open
+         * nodes and its dominance table, spilling open nodes to disk.  0 if
+         * nodes are never spilled.
+         */
+        long spill;
+
+        /** Flag indicating counters describing the run are to be written to
+         * stderr as JSON. */
+        int stats;
+} Options;
 
 /*
  * Function signature definitions.
  */
 void
-parse_args(int, char **, int *, int *, Item **);
+parse_args(int, char **, Options *);
 
 /**
  * Prints usage message on passing of bad cmd line args.
@@ -28,158 +81,205 @@ parse_args(int, char **, int *, int *, Item **);
 static void
 usage() {
         extern char * __progname;
-        fprintf(stderr, "Usage: ./%s { path to input file }\n", __progname);
-        exit(1);
-}
-
-/**
- * Prints message informing user that data is not in expected format.
- */
-void
-format_error(int lineno) {
-        fprintf(stderr, "Input data not in expected format on line %d\n",
-                        lineno);
+        fprintf(stderr, "Usage: ./%s [--method M] [--stream] [--threads N] "
+                        "[--epsilon E] [--spill MB]\n"
+                        "       [--stats] { path to input file }\n", __progname);
+        fprintf(stderr, "  -m, --method M     solver to use: auto (default), "
+                        "bb, dp, mitm\n"
+                        "                     or subset\n");
+        fprintf(stderr, "  -s, --stream       overlap reading the input "
+                        "file with solving it\n");
+        fprintf(stderr, "  -j, --threads N    partition the items across N "
+                        "threads\n");
+        fprintf(stderr, "  -e, --epsilon E    find a solution within "
+                        "(1 - E) of optimal\n");
+        fprintf(stderr, "  --spill MB         branch and bound in at most MB "
+                        "megabytes for open\n"
+                        "                     nodes and the dominance table, "
+                        "spilling open\n"
+                        "                     nodes to $TMPDIR\n");
+        fprintf(stderr, "  --stats            write counters describing the "
+                        "run, and hardware\n"
+                        "                     counters of each phase, to "
+                        "stderr as JSON\n");
+        fprintf(stderr, "-s, -j, -e and --spill each select a solver, so at "
+                        "most one may be given.\n"
+                        "-m may only name the solver they select: dp for -s "
+                        "and -j, bb for --spill.\n");
         exit(1);
 }
 
 int 
 main(int argc, char **argv) {
 
+        Options opts;   /* Options given on the cmd line. */
+        FILE *in;       /* Handle to the input file. */
         Item *items;    /* Array of Item structs defining problem instance. */
         char *sol;      /* Solution string returned by solver. */
         int n,          /* The number of items in the knapsack. */ 
             K;          /* The capacity of the knapsack. */
 
-        parse_args(argc, argv, &n, &K, &items);        
+        parse_args(argc, argv, &opts);
+
+        if (opts.stats) stats_perf_open();
+
+        stats_phase_begin(PHASE_PARSE);
+        in = parser_open(opts.path);
+        parser_read_header(in, &n, &K);
+
+        if (opts.method == METHOD_MITM && n > MITM_MAX_ITEMS) {
+                fprintf(stderr, "Meet in the middle solver accepts at most "
+                                "%d items.\n", MITM_MAX_ITEMS);
+                exit(1);
+        }
+
+        if (opts.stream) {
+                /* Reading and solving overlap, so both count as solving. */
+                stats_phase_end(PHASE_PARSE);
+                stats_phase_begin(PHASE_SOLVE);
+                sol = solve_knapsack_stream(in, n, K, &items);
+        } else {
+                /* Allocate memory for array of items. */
+                items = malloc(sizeof(Item) * (n > 0 ? n : 1));
+                if (items == NULL) {
+                        fprintf(stderr, 
+                                "Failed to allocate memory for items "
+                                "array.");
+                        exit(1);
+                }
+
+                parser_read_items(in, n, items);
+                stats_phase_end(PHASE_PARSE);
+                stats_phase_begin(PHASE_SOLVE);
 
-        sol = solve_knapsack_instance(n, K, items);
+                if (opts.method == METHOD_SUBSET &&
+                    !knapsack_is_subset_sum(n, items)) {
+                        fprintf(stderr, "Subset sum solver requires every "
+                                        "item's value to equal its weight.\n");
+                        exit(1);
+                }
+
+                if (opts.epsilon > 0)
+                        sol = solve_knapsack_fptas(n, K, items, opts.epsilon);
+                else if (opts.threads > 0)
+                        sol = solve_knapsack_partition(n, K, items,
+                                        opts.threads);
+                else if (opts.spill > 0)
+                        sol = solve_knapsack_instance_bb_spill(n, K, items,
+                                        (size_t) opts.spill * 1024 * 1024);
+                else if (opts.method == METHOD_BB)
+                        sol = solve_knapsack_instance_bb(n, K, items);
+                else if (opts.method == METHOD_DP)
+                        sol = solve_knapsack_dp(n, K, items);
+                else if (opts.method == METHOD_MITM)
+                        sol = solve_knapsack_mitm(n, K, items);
+                else if (opts.method == METHOD_SUBSET)
+                        sol = solve_knapsack_subset_sum(n, K, items);
+                else
+                        sol = solve_knapsack_instance(n, K, items);
+        }
 
+        stats_phase_end(PHASE_SOLVE);
+
+        fclose(in);
         free(items);
 
+        stats_phase_begin(PHASE_OUTPUT);
         printf("%s", sol);
+        fflush(stdout);
+        stats_phase_end(PHASE_OUTPUT);
+
+        if (opts.stats) {
+                stats_print_json(stderr);
+                perf_close();
+        }
 
         return 0;
 }
 
 /**
- * Parse command line args and initialize Item structs to be used by
- * the solver.
+ * Parse command line args.
  * @param int argc
  *      argc as passed at program execution.
  * @param char **argv
  *      argv as passed at program execution.
- * @param int *n
- *      Pointer to integer variable into which the number of items in the
- *      knapsack will be stored.
- * @param int *K
- *      Pointer to integer variable into which the capacity of the knapsack
- *      will be stored.
- * @param Item **items
- *      Pointer to array of Items.  Function will initialize needed heap memory.
+ * @param Options *opts
+ *      Pointer to the structure into which the parsed options are stored.
  */
 void
-parse_args(int argc, char **argv,int *n, int *K, Item **items) {
+parse_args(int argc, char **argv, Options *opts) {
 
-        char buf[MAX_LINE_LENGTH];
-        char *token, *err;
-        char delimiters[] = " \n";
-        FILE *in;
-        int lineno = 0, weight, value;
-
-        if (argc < NARGS) {
-                usage();
-        }
+        static struct option long_options[] = {
+                {"method", required_argument, NULL, 'm'},
+                {"stream", no_argument, NULL, 's'},
+                {"threads", required_argument, NULL, 'j'},
+                {"epsilon", required_argument, NULL, 'e'},
+                {"spill", required_argument, NULL, 'S'},
+                {"stats", no_argument, NULL, 'T'},
+                {NULL, 0, NULL, 0}
+        };
+        char *err;
+        int c;
 
-        in = fopen(argv[1], "r");
-        if (in == NULL) {
-                fprintf(stderr, "Input file: %s could not be found.\n", 
-                                argv[1]);
-                exit(1);
-        }
+        memset(opts, 0, sizeof(Options));
 
-        memset(buf, '\0', MAX_LINE_LENGTH);
-        while (fgets(buf, MAX_LINE_LENGTH, in) != NULL) {
-                if (lineno == 0) {
-                        /*
-                         * We expect first line to contain n and K separated
-                         * by a single space.
-                         */
-                        /* Get n from input file. */
-                        token = strtok(buf, delimiters);
-                        *n = (int) strtol(token, &err, 10);
-
-                        if (err[0] != '\0') {
-                                format_error(lineno); 
-                        } 
-
-                        if (*n < 0) {
-                                fprintf(stderr,
-                                        "Number of items in knapsack cannot "
-                                        "be < 0.\n");
-                                exit(1);
-                        }
-
-                        /* Get K from input file. */
-                        token = strtok(NULL, delimiters);
-                        *K = (int) strtol(token, &err, 10);
-                        
-                        if (err[0] != '\0') {
-                              format_error(lineno);
-                        }  
-
-                        if (*K < 0) {
-                                fprintf(stderr,
-                                        "Knapsack capacity cannot be < 0.\n");
-                                exit(1);
-                        }
-
-                        /* Allocate memory for array of items. */
-                        *items = malloc(sizeof(Item) * (*n));
-                        if (*items == NULL) {
-                                fprintf(stderr, 
-                                        "Failed to allocate memory for items "
-                                        "array.");
-                        }
-
-                        DEBUG_PRINT("n = %d\n K = %d\n", *n, *K);
-
-                } else {
-                        /* Instantiate no more than n items. */
-                        if (lineno > *n) break;
-
-                        /* Get item weight from input file. */
-                        /* TODO: determine if weight is allowed to be < 0. */
-                        token = strtok(buf, delimiters);
-                        value = (int) strtol(token, &err, 10);
-
-                        if (err[0] != '\0') {
-                                format_error(lineno);
-                        } 
-        
-                        /* Get item value from input file. */
-                        /* TODO: determine if value is allowed to be < 0. */
-                        token = strtok(NULL, delimiters);
-                        weight = (int) strtol(token, &err, 10);
-                        
-                        if (err[0] != '\0') {
-                                format_error(lineno);
-                        }
-
-                        (*items)[lineno - 1].id = lineno - 1;
-                        (*items)[lineno - 1].isTaken = 0;
-                        (*items)[lineno - 1].weight = weight;
-                        (*items)[lineno - 1].value = value;
-
-                        DEBUG_PRINT("items[%d].weight = %d\n items[%d].value "
-                                        "= %d\n", lineno - 1, weight, 
-                                        lineno - 1, value);
+        while ((c = getopt_long(argc, argv, "m:sj:e:", long_options, NULL)) != -1) {
+                switch (c) {
+                case 'm':
+                        if (strcmp(optarg, "auto") == 0)
+                                opts->method = METHOD_AUTO;
+                        else if (strcmp(optarg, "bb") == 0)
+                                opts->method = METHOD_BB;
+                        else if (strcmp(optarg, "dp") == 0)
+                                opts->method = METHOD_DP;
+                        else if (strcmp(optarg, "mitm") == 0)
+                                opts->method = METHOD_MITM;
+                        else if (strcmp(optarg, "subset") == 0)
+                                opts->method = METHOD_SUBSET;
+                        else
+                                usage();
+                        break;
+                case 's':
+                        opts->stream = 1;
+                        break;
+                case 'j':
+                        opts->threads = (int) strtol(optarg, &err, 10);
+                        if (err[0] != '\0' || opts->threads < 1) usage();
+                        break;
+                case 'e':
+                        opts->epsilon = strtod(optarg, &err);
+                        if (err[0] != '\0' || opts->epsilon <= 0 ||
+                            opts->epsilon >= 1) 
+                                usage();
+                        break;
+                case 'S':
+                        opts->spill = strtol(optarg, &err, 10);
+                        if (err[0] != '\0' || opts->spill < 1) usage();
+                        break;
+                case 'T':
+                        opts->stats = 1;
+                        break;
+                default:
+                        usage();
                 }
-                lineno++;
         }
 
-        if (lineno < (*n) + 1) {
-                fprintf(stderr, "Less items were given than was specified "
-                                "on first line of input.\n");
-                exit(1);
+        if (argc - optind < NARGS) {
+                usage();
         }
+
+        /* Reject options selecting different solvers. */
+        if ((opts->stream != 0) + (opts->threads > 0) + (opts->epsilon > 0) +
+            (opts->spill > 0) > 1)
+                usage();
+        if ((opts->stream || opts->threads > 0) &&
+            opts->method != METHOD_AUTO && opts->method != METHOD_DP)
+                usage();
+        if (opts->spill > 0 && opts->method != METHOD_AUTO &&
+            opts->method != METHOD_BB)
+                usage();
+        if (opts->epsilon > 0 && opts->method != METHOD_AUTO)
+                usage();
+
+        opts->path = argv[optind];
 }
@@ -0,0 +1,200 @@
+/*
+ * Module implementing the Horowitz-Sahni meet-in-the-middle algorithm for
+ * the knapsack problem.
+ *
+ * The items are split into two halves.  For each half the subsets are
+ * enumerated by repeatedly merging the list of subsets found so far with a
+ * copy of itself to which the next item is added, which keeps the list
+ * sorted by weight without a separate sort.  Subsets heavier than another
+ * subset of the same half with no more value are dominated and dropped
+ * during the merge, so each list is a Pareto frontier of at most
+ * min(2^(n/2), K + 1) entries.  A single sweep over both frontiers, one in
+ * increasing and the other in decreasing order of weight, then finds the
+ * best pair.  Runtime is O(n 2^(n/2)) regardless of the capacity.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "item.h"
+#include "mitm.h"
+#include "solver.h"
+#include "stats.h"
+#include "utils.h"
+
+/**
+ * Returns the largest number of entries the frontier of a half of the given
+ * number of items can hold.
+ */
+static size_t
+frontier_capacity(int half, int K) {
+
+        size_t subsets = (size_t) 1 << half;
+
+        return subsets < (size_t) K + 1 ? subsets : (size_t) K + 1;
+}
+
+/**
+ * Returns an estimate of the peak number of bytes the solver would allocate
+ * on an instance with n items and capacity K, or SIZE_MAX if the solver
+ * cannot handle the instance.  Intended to let the solver selection weigh
+ * this solver against the others.
+ * @param int n
+ *      The number of items in the instance.
+ * @param int K
+ *      The capacity of the knapsack.
+ */
+size_t
+mitm_memory_estimate(int n, int K) {
+
+        int half = n - n / 2;
+
+        if (n > MITM_MAX_ITEMS) return SIZE_MAX;
+
+        /* 
+         * While the second half is enumerated the first half's frontier is
+         * held alongside the list being grown and the list being merged
+         * into.
+         */
+        return (frontier_capacity(n / 2, K) + 2 * frontier_capacity(half, K)) *
+                sizeof(MitmEntry);
+}
+
+/**
+ * Enumerates the Pareto frontier of the subsets of items [lo, hi) which fit
+ * in the knapsack.
+ * @param int *count
+ *      Pointer to integer into which the number of entries is stored.
+ *
+ * @return
+ *      Array of entries in increasing order of both weight and value.
+ */
+static MitmEntry *
+frontier(Item *items, int lo, int hi, int K, int *count) {
+
+        MitmEntry *list, *merged, *tmp, next, added;
+        size_t sz = frontier_capacity(hi - lo, K);
+        int i, a, b, m, k;
+
+        list = malloc(sz * sizeof(MitmEntry));
+        merged = malloc(sz * sizeof(MitmEntry));
+        if (!list || !merged) ALLOCATION_ERROR();
+
+        list[0].weight = 0;
+        list[0].value = 0;
+        list[0].mask = 0;
+        m = 1;
+
+        for (i = lo; i < hi; i++) {
+                a = 0;
+                b = 0;
+                k = 0;
+                /* 
+                 * Merge list with list + items[i], both sorted by weight.
+                 * On equal weights the higher value comes first, so an entry
+                 * is kept only if it is worth more than the last one kept.
+                 */
+                while (a < m || b < m) {
+                        /*
+                         * Subsets which no longer fit are dropped.  Weights
+                         * are compared against what is left of K, as their
+                         * sum may not fit in an int.
+                         */
+                        if (b < m && list[b].weight > K - items[i].weight)
+                                b = m;
+
+                        if (b < m) {
+                                added.weight = list[b].weight + items[i].weight;
+                                added.value = list[b].value + items[i].value;
+                                added.mask = list[b].mask | (1u << (i - lo));
+                        }
+
+                        if (b >= m && a >= m) {
+                                break;
+                        } else if (b >= m || (a < m &&
+                            (list[a].weight < added.weight ||
+                             (list[a].weight == added.weight &&
+                              list[a].value >= added.value)))) {
+                                next = list[a++];
+                        } else {
+                                next = added;
+                                b++;
+                        }
+
+                        if (k == 0 || next.value > merged[k - 1].value)
+                                merged[k++] = next;
+                }
+
+                tmp = list;
+                list = merged;
+                merged = tmp;
+                m = k;
+        }
+
+        free(merged);
+
+        *count = m;
+        return list;
+}
+
+/**
+ * Solve instance of knapsack problem by meeting in the middle.  The number
+ * of items may not exceed MITM_MAX_ITEMS.
+ * @param int n
+ *      The number of items to be considered.
+ * @param int K
+ *      The capacity of the knapsack.
+ * @param Item *items
+ *      Array of Item structs corresponding to the items to be placed in the
+ *      knapsack. 
+ *
+ * @return
+ *      String encoding solution.
+ */
+char *
+solve_knapsack_mitm(int n, int K, Item *items) {
+
+        MitmEntry *A, *B;
+        int na, nb, i, j, half = n / 2, best = 0, best_i = 0, best_j = 0;
+
+        assert(n <= MITM_MAX_ITEMS);
+
+        stats.solver = "mitm";
+
+        A = frontier(items, 0, half, K, &na);
+        B = frontier(items, half, n, K, &nb);
+
+        /* 
+         * As A's weight increases the heaviest fitting entry of B can only
+         * move towards lighter entries.  B is a Pareto frontier, so the
+         * heaviest fitting entry is also the most valuable.
+         */
+        j = nb - 1;
+        for (i = 0; i < na; i++) {
+                while (j >= 0 && A[i].weight > K - B[j].weight) j--;
+                if (j < 0) break;
+
+                if (A[i].value + B[j].value > best) {
+                        best = A[i].value + B[j].value;
+                        best_i = i;
+                        best_j = j;
+                }
+        }
+
+        for (i = 0; i < half; i++) {
+                items[i].isTaken = (A[best_i].mask >> i) & 1;
+        }
+        for (i = half; i < n; i++) {
+                items[i].isTaken = (B[best_j].mask >> (i - half)) & 1;
+        }
+
+        DEBUG_PRINT("Solution: %d (frontiers of %d and %d subsets)\n", best,
+                        na, nb);
+
+        free(A);
+        free(B);
+
+        return knapsack_solution_string(best, 1, n, items);
+}
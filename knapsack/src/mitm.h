@@ -0,0 +1,31 @@
+/*
+ * Module defining a meet-in-the-middle solver for instances of the knapsack
+ * problem with few items and a large capacity.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef MITM_H
+#define MITM_H
+
+#include <stddef.h>
+
+#include "item.h"
+
+/**
+ * Constant defining the largest number of items the solver accepts (the
+ * subset of each half is encoded in a 32 bit mask).
+ */
+#define MITM_MAX_ITEMS 64
+
+typedef struct {
+        int weight;             /* Total weight of the subset. */
+        int value;              /* Total value of the subset. */
+        unsigned int mask;      /* Bit i set if item i of the half is taken. */
+} MitmEntry;
+
+size_t
+mitm_memory_estimate(int, int);
+
+char *
+solve_knapsack_mitm(int, int, Item *);
+
+#endif
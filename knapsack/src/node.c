@@ -1,4 +1,9 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "node.h"
+#include "utils.h"
 
 /**
  * Returns nodes bounds.  Implements the interface expected by the pqueue adt.
@@ -8,3 +13,120 @@ node_get_bound(void *x) {
         Node *n = (Node *) x;
         return n->bound;
 }
+
+/**
+ * Allocates a child of the given node in the solution tree.  The child holds
+ * a reference to its parent and is returned holding a single reference.
+ * @param Node *parent
+ *      The node being branched on, NULL for the root.
+ * @param int taken
+ *      1 if the child takes the item at its level, 0 otherwise.
+ * @param int value
+ *      The total value of the items taken along the path to the child.
+ * @param int weight
+ *      The total weight of the items taken along the path to the child.
+ */
+Node *
+node_init(Node *parent, int taken, int value, int weight) {
+
+        Node *u;
+
+        u = malloc(sizeof(Node));
+        if (!u) ALLOCATION_ERROR();
+
+        u->level = parent ? parent->level + 1 : -1;
+        u->taken = taken;
+        u->value = value;
+        u->weight = weight;
+        u->bound = 0;
+        u->refs = 1;
+        u->parent = parent;
+        u->path = NULL;
+
+        if (parent) parent->refs++;
+
+        return u;
+}
+
+/**
+ * Drops a reference to the given node, freeing it and any ancestors no
+ * longer referenced.
+ */
+void
+node_release(Node *u) {
+
+        Node *parent;
+
+        while (u && --u->refs == 0) {
+                parent = u->parent;
+                free(u->path);
+                free(u);
+                u = parent;
+        }
+}
+
+/**
+ * Writes a bitmap of the items taken along the path to the given node: bit
+ * l of the bitmap is set if the item at level l was taken.
+ * @param Node *u
+ *      The node.
+ * @param unsigned char *path
+ *      Buffer receiving the bitmap.
+ * @param size_t len
+ *      Length of the bitmap in bytes, enough for a bit per level.
+ */
+void
+node_get_path(Node *u, unsigned char *path, size_t len) {
+
+        size_t i;
+
+        memset(path, 0, len);
+
+        for (; u && u->level >= 0; u = u->parent) {
+                if (u->path) {
+                        /* Levels up to u's are recorded in its own bitmap. */
+                        for (i = 0; i < len; i++) path[i] |= u->path[i];
+                        return;
+                }
+                if (u->taken) path[u->level / 8] |= 1 << (u->level % 8);
+        }
+}
+
+/**
+ * Allocates a node restored from disk, which holds the bitmap of the items
+ * taken along its path in place of a reference to its parent.  The node is
+ * returned holding a single reference.
+ * @param int level
+ *      The level of the node.
+ * @param int value
+ *      The total value of the items taken along the path to the node.
+ * @param int weight
+ *      The total weight of the items taken along the path to the node.
+ * @param unsigned char *path
+ *      The bitmap of the items taken, as written by node_get_path().
+ * @param size_t len
+ *      Length of the bitmap in bytes.
+ */
+Node *
+node_restore(int level, int value, int weight, unsigned char *path,
+    size_t len) {
+
+        Node *u;
+
+        u = malloc(sizeof(Node));
+        if (!u) ALLOCATION_ERROR();
+
+        u->path = malloc(len > 0 ? len : 1);
+        if (!u->path) ALLOCATION_ERROR();
+        memcpy(u->path, path, len);
+
+        u->level = level;
+        u->taken = level >= 0 && (path[level / 8] >> (level % 8)) & 1;
+        u->value = value;
+        u->weight = weight;
+        u->bound = 0;
+        u->refs = 1;
+        u->parent = NULL;
+
+        return u;
+}
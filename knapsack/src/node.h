@@ -5,14 +5,50 @@
 #ifndef NODE_H
 #define NODE_H
 
-typedef struct {
+#include <stddef.h>
+
+typedef struct Node {
         double bound;
         int value;
         int weight;
         int level;
+
+        /** 1 if the item at this node's level was taken, 0 otherwise. */
+        int taken;
+
+        /**
+         * Number of references held to the node (by the priority queue, by
+         * its children and by the best solution found).
+         */
+        int refs;
+
+        /**
+         * The node from which this node was branched, NULL for the root and
+         * for nodes restored from disk.
+         */
+        struct Node *parent;
+
+        /**
+         * For a node restored from disk, a bitmap of the items taken along
+         * its path (bit l set if the item at level l was taken), NULL
+         * otherwise.
+         */
+        unsigned char *path;
 } Node;
 
 double 
 node_get_bound(void *);
 
+Node *
+node_init(Node *, int, int, int);
+
+void
+node_release(Node *);
+
+void
+node_get_path(Node *, unsigned char *, size_t);
+
+Node *
+node_restore(int, int, int, unsigned char *, size_t);
+
 #endif
@@ -0,0 +1,159 @@
+/*
+ * Module implementing functionality used to read an instance of the knapsack
+ * problem from an input file.  The first line of the file is expected to
+ * contain the number of items n and the capacity K, each of the n lines
+ * thereafter the value and weight of a single item.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "item.h"
+#include "parser.h"
+#include "utils.h"
+
+/**
+ * Prints message informing user that data is not in expected format.
+ */
+static void
+format_error(int lineno) {
+        fprintf(stderr, "Input data not in expected format on line %d\n",
+                        lineno);
+        exit(1);
+}
+
+/**
+ * Parses the next whitespace delimited integer token on the current line.
+ * Exits with a format error if the token is missing or malformed.
+ */
+static int
+parse_int(char *buf, int lineno) {
+
+        char delimiters[] = " \n";
+        char *token, *err;
+        int x;
+
+        token = strtok(buf, delimiters);
+        if (token == NULL) format_error(lineno);
+
+        x = (int) strtol(token, &err, 10);
+        if (err[0] != '\0') format_error(lineno);
+
+        return x;
+}
+
+/**
+ * Opens the input file found at the given path.
+ * @param const char *path
+ *      Path to the input file.
+ * @return
+ *      Handle to the opened file.  Function exits program if the file
+ *      cannot be opened.
+ */
+FILE *
+parser_open(const char *path) {
+
+        FILE *in;
+
+        in = fopen(path, "r");
+        if (in == NULL) {
+                fprintf(stderr, "Input file: %s could not be found.\n", path);
+                exit(1);
+        }
+
+        return in;
+}
+
+/**
+ * Reads the first line of the input file.  We expect the first line to
+ * contain n and K separated by a single space.
+ * @param FILE *in
+ *      Handle to the input file.
+ * @param int *n
+ *      Pointer to integer variable into which the number of items in the
+ *      knapsack will be stored.
+ * @param int *K
+ *      Pointer to integer variable into which the capacity of the knapsack
+ *      will be stored.
+ */
+void
+parser_read_header(FILE *in, int *n, int *K) {
+
+        char buf[MAX_LINE_LENGTH];
+
+        memset(buf, '\0', MAX_LINE_LENGTH);
+        if (fgets(buf, MAX_LINE_LENGTH, in) == NULL) format_error(0);
+
+        /* Get n from input file. */
+        *n = parse_int(buf, 0);
+        if (*n < 0) {
+                fprintf(stderr,
+                        "Number of items in knapsack cannot be < 0.\n");
+                exit(1);
+        }
+
+        /* Get K from input file. */
+        *K = parse_int(NULL, 0);
+        if (*K < 0) {
+                fprintf(stderr, "Knapsack capacity cannot be < 0.\n");
+                exit(1);
+        }
+
+        DEBUG_PRINT("n = %d\n K = %d\n", *n, *K);
+}
+
+/**
+ * Reads the next item from the input file.
+ * @param FILE *in
+ *      Handle to the input file, positioned after the header line.
+ * @param int id
+ *      The id to be given to the item (i.e., its position in the input file).
+ * @param Item *item
+ *      Pointer to the Item struct to be initialized.
+ * @return
+ *      1 if an item was read, 0 if the end of the file was reached.
+ */
+int
+parser_read_item(FILE *in, int id, Item *item) {
+
+        char buf[MAX_LINE_LENGTH];
+        int lineno = id + 1;
+
+        memset(buf, '\0', MAX_LINE_LENGTH);
+        if (fgets(buf, MAX_LINE_LENGTH, in) == NULL) return 0;
+
+        /* TODO: determine if value or weight are allowed to be < 0. */
+        item->value = parse_int(buf, lineno);
+        item->weight = parse_int(NULL, lineno);
+        item->id = id;
+        item->isTaken = 0;
+
+        DEBUG_PRINT("items[%d].weight = %d\n items[%d].value = %d\n",
+                        id, item->weight, id, item->value);
+
+        return 1;
+}
+
+/**
+ * Reads the n items following the header line of the input file.
+ * @param FILE *in
+ *      Handle to the input file, positioned after the header line.
+ * @param int n
+ *      The number of items to be read.
+ * @param Item *items
+ *      Array of at least n Items into which the items are read.
+ */
+void
+parser_read_items(FILE *in, int n, Item *items) {
+
+        int i;
+
+        for (i = 0; i < n; i++) {
+                if (!parser_read_item(in, i, &items[i])) {
+                        fprintf(stderr, "Less items were given than was "
+                                        "specified on first line of input.\n");
+                        exit(1);
+                }
+        }
+}
@@ -0,0 +1,30 @@
+/*
+ * Module defining functionality used to read an instance of the knapsack
+ * problem from an input file.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <stdio.h>
+
+#include "item.h"
+
+/*
+ * Define max length of line we will read from input file.
+ */
+#define MAX_LINE_LENGTH 128
+
+FILE *
+parser_open(const char *);
+
+void
+parser_read_header(FILE *, int *, int *);
+
+int
+parser_read_item(FILE *, int, Item *);
+
+void
+parser_read_items(FILE *, int, Item *);
+
+#endif
@@ -0,0 +1,407 @@
+/*
+ * Module implementing a parallel dynamic programming solver for the knapsack
+ * problem in which the set of items, rather than the capacity axis, is split
+ * across threads.
+ *
+ * Each thread computes the profile P of its group of items, where P[w] is the
+ * best value achievable by the group with capacity w.  Profiles of sibling
+ * groups are combined with a (max,+) convolution
+ *
+ *      P[w] = max_{0 <= j <= w} (A[j] + B[w - j])
+ *
+ * and the optimal value is the best split of K between the two halves of the
+ * item set.  The items taken are recovered by recursing into each half with
+ * the capacity it received in the winning split.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "item.h"
+#include "partition.h"
+#include "solver.h"
+#include "stats.h"
+#include "utils.h"
+
+typedef struct {
+        Item *items;
+        int lo;         /* Index of the first item in the group. */
+        int hi;         /* Index one past the last item in the group. */
+        int c;          /* The capacity available to the group. */
+        int threads;    /* The number of threads the group may use. */
+        int *P;         /* Profile of the group (ProfileTask only). */
+} Task;
+
+static void
+profile_compute(Item *, int, int, int, int, int *);
+
+static void
+reconstruct(Item *, int, int, int, int);
+
+static void *
+profile_task_run(void *x) {
+        Task *t = (Task *) x;
+        profile_compute(t->items, t->lo, t->hi, t->c, t->threads, t->P);
+        return NULL;
+}
+
+static void *
+reconstruct_task_run(void *x) {
+        Task *t = (Task *) x;
+        reconstruct(t->items, t->lo, t->hi, t->c, t->threads);
+        return NULL;
+}
+
+/**
+ * Runs the two given tasks, concurrently if more than one thread is
+ * available, and returns once both are complete.
+ */
+static void
+fork_join(void *(*run)(void *), Task *a, Task *b, int threads) {
+
+        pthread_t thread;
+
+        if (threads > 1 && pthread_create(&thread, NULL, run, a) == 0) {
+                run(b);
+                pthread_join(thread, NULL);
+        } else {
+                run(a);
+                run(b);
+        }
+}
+
+/**
+ * Initializes the two tasks splitting the group [lo, hi) in half.  The
+ * available threads are divided between the halves.
+ */
+static void
+split_tasks(Task *a, Task *b, Item *items, int lo, int hi, int c,
+    int threads) {
+
+        a->items = b->items = items;
+        a->lo = lo;
+        a->hi = b->lo = lo + (hi - lo) / 2;
+        b->hi = hi;
+        a->c = b->c = c;
+        a->threads = threads / 2 > 0 ? threads / 2 : 1;
+        b->threads = threads - a->threads > 0 ? threads - a->threads : 1;
+        a->P = b->P = NULL;
+}
+
+/**
+ * Applies items [lo, hi) to the given profile using a single rolling row.
+ */
+static void
+profile_extend(Item *items, int lo, int hi, int c, int *P) {
+
+        long long cells = 0;
+        int i, w, candidate;
+
+        for (i = lo; i < hi; i++) {
+                for (w = c; w >= items[i].weight; w--) {
+                        candidate = P[w - items[i].weight] + items[i].value;
+                        if (candidate > P[w]) P[w] = candidate;
+                }
+                if (items[i].weight <= c) cells += c - items[i].weight + 1;
+        }
+
+        stats_add_dp_cells(cells);
+}
+
+/**
+ * Returns 1 if the differences between consecutive entries of the profile
+ * are non-increasing, 0 otherwise.
+ */
+static int
+profile_is_concave(int *P, int c) {
+
+        int w;
+
+        for (w = 1; w < c; w++) {
+                if (P[w + 1] - P[w] > P[w] - P[w - 1]) return 0;
+        }
+        return 1;
+}
+
+/**
+ * Collects the capacities at which the profile increases (and capacity 0).
+ * @return
+ *      The number of breakpoints stored in bp.
+ */
+static int
+profile_breakpoints(int *P, int c, int *bp) {
+
+        int w, count = 0;
+
+        bp[count++] = 0;
+        for (w = 1; w <= c; w++) {
+                if (P[w] != P[w - 1]) bp[count++] = w;
+        }
+        return count;
+}
+
+/**
+ * Computes out[k] for klo <= k <= khi given that the largest optimal j is
+ * known to lie in [jlo, jhi].  When B is concave the largest optimal j is
+ * non-decreasing in k (the row maxima of the matrix A[j] + B[k - j] are
+ * monotone, the property SMAWK relies on), so each level of the recursion
+ * scans every column at most twice.
+ */
+static void
+convolve_monotone(int *A, int *B, int *out, int klo, int khi, int jlo,
+    int jhi) {
+
+        int k, j, best, best_j, candidate, last;
+
+        if (klo > khi) return;
+
+        k = klo + (khi - klo) / 2;
+        last = jhi < k ? jhi : k;
+        best = A[jlo] + B[k - jlo];
+        best_j = jlo;
+        for (j = jlo + 1; j <= last; j++) {
+                candidate = A[j] + B[k - j];
+                if (candidate >= best) {
+                        best = candidate;
+                        best_j = j;
+                }
+        }
+        out[k] = best;
+
+        convolve_monotone(A, B, out, klo, k - 1, jlo, best_j);
+        convolve_monotone(A, B, out, k + 1, khi, best_j, jhi);
+}
+
+/**
+ * Computes the (max,+) convolution of two non-decreasing profiles over
+ * capacities 0..c.  If either profile is concave the convolution is found in
+ * O(c log c).  Otherwise only capacities at which the profiles increase can
+ * contribute, so pairs of breakpoints are combined and the result is made
+ * non-decreasing by a running maximum.
+ * @param int *A
+ *      Profile of the first group of items.
+ * @param int *B
+ *      Profile of the second group of items.
+ * @param int c
+ *      The largest capacity in the profiles.
+ * @param int *out
+ *      Array of c + 1 integers into which the convolution is stored.  May not
+ *      alias A or B.
+ */
+void
+maxplus_convolve(int *A, int *B, int c, int *out) {
+
+        int *bpa, *bpb, na, nb, i, j, w;
+
+        if (profile_is_concave(B, c)) {
+                convolve_monotone(A, B, out, 0, c, 0, c);
+                return;
+        }
+        if (profile_is_concave(A, c)) {
+                convolve_monotone(B, A, out, 0, c, 0, c);
+                return;
+        }
+
+        bpa = malloc((c + 1) * sizeof(int));
+        bpb = malloc((c + 1) * sizeof(int));
+        if (!bpa || !bpb) ALLOCATION_ERROR();
+
+        na = profile_breakpoints(A, c, bpa);
+        nb = profile_breakpoints(B, c, bpb);
+
+        memset(out, 0, (c + 1) * sizeof(int));
+        for (i = 0; i < na; i++) {
+                for (j = 0; j < nb && bpa[i] + bpb[j] <= c; j++) {
+                        w = bpa[i] + bpb[j];
+                        if (A[bpa[i]] + B[bpb[j]] > out[w])
+                                out[w] = A[bpa[i]] + B[bpb[j]];
+                }
+        }
+        for (w = 1; w <= c; w++) {
+                if (out[w - 1] > out[w]) out[w] = out[w - 1];
+        }
+
+        free(bpa);
+        free(bpb);
+}
+
+/**
+ * Returns an upper bound on the number of operations the breakpoint based
+ * convolution of the two profiles would take.
+ */
+static double
+convolve_cost(int *A, int *B, int c) {
+
+        int w, na = 1, nb = 1;
+
+        if (profile_is_concave(A, c) || profile_is_concave(B, c)) return c;
+
+        for (w = 1; w <= c; w++) {
+                if (A[w] != A[w - 1]) na++;
+                if (B[w] != B[w - 1]) nb++;
+        }
+        return (double) na * (double) nb;
+}
+
+/**
+ * Computes the profile of items [lo, hi) over capacities 0..c.  With more
+ * than one thread the group is split in half, the halves are computed
+ * concurrently and their profiles merged.  If merging would cost more than
+ * applying the second half's items to the first half's profile directly, the
+ * latter is done instead.
+ */
+static void
+profile_compute(Item *items, int lo, int hi, int c, int threads, int *P) {
+
+        Task a, b;
+
+        if (threads <= 1 || hi - lo < 2) {
+                memset(P, 0, (c + 1) * sizeof(int));
+                profile_extend(items, lo, hi, c, P);
+                return;
+        }
+
+        split_tasks(&a, &b, items, lo, hi, c, threads);
+        a.P = malloc((c + 1) * sizeof(int));
+        b.P = malloc((c + 1) * sizeof(int));
+        if (!a.P || !b.P) ALLOCATION_ERROR();
+
+        fork_join(profile_task_run, &a, &b, threads);
+
+        if (convolve_cost(a.P, b.P, c) <= (double) (b.hi - b.lo) * (c + 1)) {
+                maxplus_convolve(a.P, b.P, c, P);
+        } else {
+                memcpy(P, a.P, (c + 1) * sizeof(int));
+                profile_extend(items, b.lo, b.hi, c, P);
+        }
+
+        free(a.P);
+        free(b.P);
+}
+
+/**
+ * Sets the isTaken attribute of items [lo, hi) given the group is allotted
+ * capacity c, using a decision bit matrix over the group.
+ */
+static void
+reconstruct_direct(Item *items, int lo, int hi, int c) {
+
+        unsigned char *taken, *row;
+        size_t stride = (size_t) c / 8 + 1;
+        long long cells = 0;
+        int *P, i, w, candidate;
+
+        P = calloc(c + 1, sizeof(int));
+        taken = calloc((size_t) (hi - lo) * stride, 1);
+        if (!P || !taken) ALLOCATION_ERROR();
+
+        for (i = lo; i < hi; i++) {
+                row = taken + (size_t) (i - lo) * stride;
+                for (w = c; w >= items[i].weight; w--) {
+                        candidate = P[w - items[i].weight] + items[i].value;
+                        if (candidate > P[w]) {
+                                P[w] = candidate;
+                                row[w >> 3] |= 1 << (w & 7);
+                        }
+                }
+                if (items[i].weight <= c) cells += c - items[i].weight + 1;
+        }
+
+        stats_add_dp_cells(cells);
+
+        w = c;
+        for (i = hi - 1; i >= lo; i--) {
+                row = taken + (size_t) (i - lo) * stride;
+                items[i].isTaken = (row[w >> 3] >> (w & 7)) & 1;
+                if (items[i].isTaken) w -= items[i].weight;
+        }
+
+        free(taken);
+        free(P);
+}
+
+/**
+ * Sets the isTaken attribute of items [lo, hi) given the group is allotted
+ * capacity c.  The group is split in half, the capacity of the winning split
+ * between the halves' profiles is found, and we recurse into each half with
+ * the capacity it was given.
+ */
+static void
+reconstruct(Item *items, int lo, int hi, int c, int threads) {
+
+        Task a, b;
+        int w, best, best_w;
+
+        if (hi - lo == 1) {
+                items[lo].isTaken = items[lo].weight <= c &&
+                        items[lo].value > 0;
+                return;
+        }
+        if (threads <= 1 &&
+            (size_t) (hi - lo) * ((size_t) c / 8 + 1) <= PARTITION_LEAF_BYTES) {
+                reconstruct_direct(items, lo, hi, c);
+                return;
+        }
+
+        split_tasks(&a, &b, items, lo, hi, c, threads);
+        a.P = malloc((c + 1) * sizeof(int));
+        b.P = malloc((c + 1) * sizeof(int));
+        if (!a.P || !b.P) ALLOCATION_ERROR();
+
+        fork_join(profile_task_run, &a, &b, threads);
+
+        best = a.P[0] + b.P[c];
+        best_w = 0;
+        for (w = 1; w <= c; w++) {
+                if (a.P[w] + b.P[c - w] > best) {
+                        best = a.P[w] + b.P[c - w];
+                        best_w = w;
+                }
+        }
+
+        free(a.P);
+        free(b.P);
+
+        a.c = best_w;
+        b.c = c - best_w;
+        fork_join(reconstruct_task_run, &a, &b, threads);
+}
+
+/**
+ * Solve instance of knapsack problem by partitioning the items across the
+ * given number of threads.
+ * @param int n
+ *      The number of items to be considered.
+ * @param int K
+ *      The capacity of the knapsack.
+ * @param Item *items
+ *      Array of Item structs corresponding to the items to be placed in the
+ *      knapsack. 
+ * @param int threads
+ *      The number of threads to be used.
+ *
+ * @return
+ *      String encoding solution.
+ */
+char *
+solve_knapsack_partition(int n, int K, Item *items, int threads) {
+
+        int i, value = 0;
+
+        assert(threads > 0);
+
+        stats.solver = "partition";
+
+        if (n > 0) reconstruct(items, 0, n, K, threads);
+
+        for (i = 0; i < n; i++) {
+                if (items[i].isTaken) value += items[i].value;
+        }
+
+        DEBUG_PRINT("Solution: %d\n", value);
+
+        return knapsack_solution_string(value, 1, n, items);
+}
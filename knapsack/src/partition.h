@@ -0,0 +1,24 @@
+/*
+ * Module defining a parallel dynamic programming solver for the knapsack
+ * problem which partitions the set of items across threads.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "item.h"
+
+/**
+ * Constant defining the largest decision bit matrix (in bytes) a single
+ * thread will allocate to reconstruct the items taken from a group directly
+ * rather than by further splitting the group.
+ */
+#define PARTITION_LEAF_BYTES (64 * 1024 * 1024)
+
+char *
+solve_knapsack_partition(int, int, Item *, int);
+
+void
+maxplus_convolve(int *, int *, int, int *);
+
+#endif
@@ -9,12 +9,39 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "dheap.h"
+#include "dominance.h"
+#include "empqueue.h"
 #include "node.h"
 #include "item.h"
-#include "pqueue.h"
+#include "mitm.h"
+#include "partition.h"
 #include "solver.h"
+#include "stats.h"
+#include "stream.h"
+#include "subset.h"
 #include "utils.h"
 
+/*
+ * Constant defining the most memory (in bytes) a solver may be expected to
+ * use for it to be selected automatically.
+ */
+#define SELECT_MAX_BYTES (512UL * 1024 * 1024)
+
+/*
+ * Constants defining the cost of expanding a node of the branch and bound
+ * search, in dynamic programming cells taking as long (measured at about
+ * 3-4.5 us per node against about 2 ns per cell), and the memory it may hold.
+ */
+#define BB_NODE_COST 2048
+#define BB_NODE_BYTES 128
+
+/*
+ * Constant added to bounds before truncating them to integers, to guard
+ * against rounding error in the fractional part of the bound.
+ */
+#define BOUND_TOLERANCE 1e-9
+
 /**
  * Prints message indicating memory allocation failure and exits program.
  */
@@ -33,18 +60,23 @@ static void
 construct_solution(int **, int, int, Item *);
 
 static char *
-construct_solution_string(int **, int, int, Item *);
+solve_knapsack_instance_dp(int, int, Item *);
 
 static char *
-solve_knapsack_instance_bb(int, int, Item *);
-
-static char *
-solve_knapsack_instance_dp(int, int, Item *);
+solve_bb(int, int, Item *, size_t, long);
 
 
 
 /**
- * Solve instance of knapsack problem parameterized by given arguments.
+ * Solve instance of knapsack problem parameterized by given arguments,
+ * selecting the solver expected to be fastest on the instance.  The
+ * meet-in-the-middle solver is the alternative when its O(n 2^(n/2)) work
+ * is less than the O(nK) work of dynamic programming (O(nK / 64) for subset
+ * sum instances) and its memory estimate is acceptable.  The work of branch
+ * and bound cannot be predicted, so it runs first and is abandoned once it
+ * has expanded as many nodes as the alternative's work would take, or as
+ * SELECT_MAX_BYTES would hold.  At worst twice the alternative's time is
+ * spent.
  * @param int n
  *      The number of items to be considered.
  * @param int K
@@ -58,7 +90,45 @@ solve_knapsack_instance_dp(int, int, Item *);
  */
 char *
 solve_knapsack_instance(int n, int K, Item *items) {
-        return solve_knapsack_instance_bb(n, K, items);
+
+        double mitm_cost, dp_cost, cost, max_nodes;
+        char *sol;
+        int subset_sum = knapsack_is_subset_sum(n, items), mitm = 0;
+
+        dp_cost = (double) n * ((double) K + 1);
+        if (subset_sum) dp_cost /= 64;
+        cost = dp_cost;
+
+        if (mitm_memory_estimate(n, K) <= SELECT_MAX_BYTES) {
+                mitm_cost = (double) n * (double) ((size_t) 1 << (n - n / 2));
+                if (mitm_cost < dp_cost) {
+                        mitm = 1;
+                        cost = mitm_cost;
+                }
+        }
+
+        max_nodes = cost / BB_NODE_COST;
+        if (max_nodes > SELECT_MAX_BYTES / BB_NODE_BYTES)
+                max_nodes = SELECT_MAX_BYTES / BB_NODE_BYTES;
+
+        sol = solve_bb(n, K, items, 0, (long) max_nodes + 1);
+        if (sol) {
+                DEBUG_PRINT("Selected branch and bound solver.\n");
+                return sol;
+        }
+
+        if (mitm) {
+                DEBUG_PRINT("Selected meet-in-the-middle solver.\n");
+                return solve_knapsack_mitm(n, K, items);
+        }
+
+        if (subset_sum) {
+                DEBUG_PRINT("Selected subset sum solver.\n");
+                return solve_knapsack_subset_sum(n, K, items);
+        }
+
+        DEBUG_PRINT("Selected dynamic programming solver.\n");
+        return solve_knapsack_dp(n, K, items);
 }
 
 /**
@@ -73,7 +143,7 @@ solve_knapsack_instance_dp(int n, int K, Item *items) {
          * A[i, w] = max(A[i-1, w], v_i + A[i=1, w-w_i])
          */
         Item item;
-        int **A, i, w; 
+        int **A, i, w, value;
 
         /* 
          * Init solution matrix and auxilliary boolean matrix used in 
@@ -108,8 +178,9 @@ solve_knapsack_instance_dp(int n, int K, Item *items) {
 
         /* Construct solution from values in matrix of sub-solutions. */
         construct_solution(A, n, K, items);
+        value = A[n][K];
 
-        DEBUG_PRINT("Solution: %d\n", A[n][K]);
+        DEBUG_PRINT("Solution: %d\n", value);
 
 
 #ifdef DEBUG
@@ -122,7 +193,7 @@ solve_knapsack_instance_dp(int n, int K, Item *items) {
                 }
         }
 
-        assert(value_sum == A[n][K] && "Sum of values of items in knapsack"
+        assert(value_sum == value && "Sum of values of items in knapsack"
                                        "should match value of final solution.");
         assert(weight_sum <= K && "Sum of weights of items in knapsack should"
                                   "be less than capacity of knapsack.");
@@ -134,7 +205,7 @@ solve_knapsack_instance_dp(int n, int K, Item *items) {
         }
         free(A);
 
-        return construct_solution_string(A, n, K, items);
+        return knapsack_solution_string(value, 1, n, items);
 
 } 
 
@@ -160,10 +231,27 @@ construct_solution(int **A, int n, int K, Item *items) {
         } 
 }
 
-static char *
-construct_solution_string(int **A, int n, int K, Item *items) {
+/**
+ * Encodes a solution to an instance of the knapsack problem in the expected
+ * output format.  The first line contains the value of the solution and
+ * whether it is known to be optimal, the second line whether each item was
+ * taken.
+ * @param int value
+ *      The value of the solution.
+ * @param int optimal
+ *      1 if the solution is known to be optimal, 0 otherwise.
+ * @param int n
+ *      The number of items in the instance.
+ * @param Item *items
+ *      Array of Item structs whose isTaken attributes encode the solution.
+ *
+ * @return
+ *      String encoding solution.
+ */
+char *
+knapsack_solution_string(int value, int optimal, int n, Item *items) {
 
-        char *sol, *is_taken_str;
+        char *sol;
         int len, i;
         
         /* Calculate space required to create string. */
@@ -171,7 +259,7 @@ construct_solution_string(int **A, int n, int K, Item *items) {
          * For first line, need (MAX LENGTH IN DIGITS OF INTEGER) + 
          * 4 bytes (3 whitespace bytes, 1 byte for optimality boolean)
          */
-        len = 9 + 4;
+        len = 11 + 4;
 
         /* 
          * For second line, need 2*n bytes (1 byte for each boolean indicating
@@ -182,109 +270,321 @@ construct_solution_string(int **A, int n, int K, Item *items) {
         sol = malloc((len + 1) * sizeof(char));
         if (!sol) allocation_error();
         
-        is_taken_str = malloc((2*n + 1) * sizeof(char));
-        if (!is_taken_str) allocation_error();
+        len = sprintf(sol, "%d %d\n", value, optimal);
 
-        sprintf(sol, "%d %d\n", A[n][K], 1);
+        stats.value = value;
+        stats.optimal = optimal;
 
-        for (i = 0; i < 2*n; i += 2) {
-                is_taken_str[i] = items[i / 2].isTaken ? '1' : '0';
-                is_taken_str[i+1] = ' ';
+        for (i = 0; i < n; i++) {
+                sol[len++] = items[i].isTaken ? '1' : '0';
+                sol[len++] = ' ';
         }
-        is_taken_str[2*n] = '\n';
-        is_taken_str[(2*n) + 1] = '\0';
+        sol[len++] = '\n';
+        sol[len] = '\0';
 
-        strcat(sol, is_taken_str);
-        
         DEBUG_PRINT("Solution string: %s\n", sol);
        
         return sol; 
 }
 
+/* Qsort comparison function ordering items by decreasing value density. */
+static int
+item_density_comp(const void *a, const void *b) {
+        const Item *x = (const Item *) a;
+        const Item *y = (const Item *) b;
+        double dx = (double) x->value * y->weight;
+        double dy = (double) y->value * x->weight;
+        if (dx > dy) return -1;
+        else if (dy > dx) return 1;
+        return 0;
+}
+
+/*
+ * Max heap of nodes of the solution tree keyed by their bounds.
+ */
+DHEAP_DEFINE(NodeHeap, Node *)
+
+/*
+ * Record of an open node held by the external memory queue, its bound being
+ * the record's priority.  The items taken along the node's path are stored
+ * in the record, so it holds no reference to the node's ancestors.
+ */
+typedef struct {
+        int level;
+        int value;
+        int weight;
+
+        /** Bitmap of the items taken, as written by node_get_path(). */
+        unsigned char path[];
+} NodeRecord;
+
+/*
+ * The open nodes of the branch and bound search, held either in a heap in
+ * memory or in an external memory queue spilling to disk.
+ */
+typedef struct {
+        NodeHeap heap;
+        EMPQueue *epq;
+        NodeRecord *record;     /* Buffer for a record of the queue. */
+        size_t path_len;        /* Length in bytes of a record's path. */
+        long open;              /* Number of nodes in the frontier. */
+} Frontier;
+
 /**
- * Solve given instance of the knapsack problem using a branch and bound
- * approach.
- * TODO: the solution presented below represents a "rough" attempt and is not
- * in anyway optimized.
- * TODO: solution in terms of which items are picked along the optimal path
- * could easily be recovered by associating with each node a bitvector 
- * encoding the decision made along the tree in order to arrive at that
- * particular node (e.g., for the node encoding that we did not take
- * the first item, but took the second and third items, the node's bit vector
- * would be equal to 011) 
+ * Adds the given node to the frontier.  The external memory queue stores a
+ * record of the node, which is then released along with any ancestors no
+ * longer referenced.
  */
-static char *
-solve_knapsack_instance_bb(int n, int K, Item *items) {
+static void
+frontier_push(Frontier *f, Node *u) {
 
-        PQueue *pq;
-        Node *u, *v; 
-        Item tmp;
-        int maxvalue;
-        char *sol = malloc(128 * sizeof(char));
-        
-        pq = pqueue_init(n, node_get_bound);
+        if (++f->open > stats.peak_open) stats.peak_open = f->open;
 
-        v = malloc(sizeof(Item));
-        if (!v) allocation_error();
+        if (!f->epq) {
+                NodeHeap_push(&f->heap, u, u->bound);
+                return;
+        }
 
-        v->level = -1;
-        v->value = 0;
-        v->weight = 0;
+        f->record->level = u->level;
+        f->record->value = u->value;
+        f->record->weight = u->weight;
+        node_get_path(u, f->record->path, f->path_len);
+        empqueue_enqueue(f->epq, f->record, u->bound);
+        node_release(u);
+}
 
-        pqueue_enqueue(pq, (void *) v); 
+/**
+ * Removes the node with the highest bound from the frontier.
+ * @return
+ *      The node, holding a single reference, or NULL if the frontier is
+ *      empty.
+ */
+static Node *
+frontier_pop(Frontier *f) {
 
-        /* While priority queue is not empty ... */
-        while (pq->nElements > 1) {
+        Node *v;
+        double bound;
 
-                pqueue_dequeue(pq, (void **) &v, NULL);
+        if (!f->epq) {
+                if (NodeHeap_is_empty(&f->heap)) return NULL;
+                f->open--;
+                return NodeHeap_pop(&f->heap, NULL);
+        }
 
-                v->bound = bound(n, K, items, v);
+        if (!empqueue_dequeue(f->epq, f->record, &bound)) return NULL;
+        f->open--;
 
-                DEBUG_PRINT("maxvalue: %d\t v->bound: %f", maxvalue, v->bound);
+        v = node_restore(f->record->level, f->record->value,
+                        f->record->weight, f->record->path, f->path_len);
+        v->bound = bound;
 
-                if (v->bound > maxvalue) {
+        return v;
+}
 
-                        /* Set u to be child that includes next item. */
-                        /* Better solution: preallocate and dynamically grow
-                         * array of Items to be used as nodes in search tree */
-                        u = malloc(sizeof(Node));
-                        if (!u) allocation_error();
+/**
+ * Enqueues the given child unless its bound cannot improve on the best
+ * solution found or it is dominated by another node at its level, in which
+ * case it is released.
+ */
+static void
+enqueue_child(Frontier *f, DominanceTable *dt, int n, int K, Item *items,
+    Node *u, int maxvalue) {
+
+        u->bound = bound(n, K, items, u);
+
+        if ((int) (u->bound + BOUND_TOLERANCE) <= maxvalue) {
+                stats.pruned_bound++;
+                node_release(u);
+        } else if (!dominance_insert(dt, u->level, u->weight, u->value)) {
+                stats.pruned_dominated++;
+                node_release(u);
+        } else {
+                stats.enqueued++;
+                frontier_push(f, u);
+        }
+}
 
-                        u->level = v->level + 1;
-                        u->weight = v->weight + items[u->level].weight;
-                        u->value = v->value + items[u->level].value;
+/**
+ * Solve given instance of the knapsack problem using a best-first branch and
+ * bound approach.  Items are considered in decreasing order of value
+ * density so that bound() is the value of the linear relaxation.  A node is
+ * discarded before being enqueued if another node at the same level is no
+ * heavier and worth at least as much, and skipped when dequeued if such a
+ * node was enqueued after it.  The items taken are recovered by walking the
+ * parent pointers of the best node found.
+ */
+char *
+solve_knapsack_instance_bb(int n, int K, Item *items) {
+        return solve_knapsack_instance_bb_spill(n, K, items, 0);
+}
 
-                        if (u->weight <= K && u->value > maxvalue) 
-                                maxvalue = u->value;
+/**
+ * Solve given instance of the knapsack problem using a best-first branch and
+ * bound approach in bounded memory.  Half of the memory holds the open nodes
+ * with the highest bounds, the rest being spilled to disk, and half the
+ * dominance table, which evicts entries once full.
+ * @param int n
+ *      The number of items to be considered.
+ * @param int K
+ *      The capacity of the knapsack.
+ * @param Item *items
+ *      Array of Item structs corresponding to the items to be placed in the
+ *      knapsack. 
+ * @param size_t max_bytes
+ *      The memory in bytes for open nodes and the dominance table, 0 to
+ *      hold every open node in memory.
+ *
+ * @return
+ *      String encoding solution.
+ */
+char *
+solve_knapsack_instance_bb_spill(int n, int K, Item *items, size_t max_bytes) {
+        return solve_bb(n, K, items, max_bytes, 0);
+}
+
+/**
+ * Runs the branch and bound search of solve_knapsack_instance_bb_spill(),
+ * giving up once max_nodes nodes have been expanded.
+ * @param long max_nodes
+ *      The most nodes to expand, 0 for no limit.
+ *
+ * @return
+ *      String encoding solution, or NULL if the search gave up, in which
+ *      case the items are left unchanged.
+ */
+static char *
+solve_bb(int n, int K, Item *items, size_t max_bytes, long max_nodes) {
+
+        Frontier f;
+        DominanceTable *dt;
+        Node *u, *v, *best = NULL; 
+        Item *sorted, *item;
+        unsigned char *path;
+        size_t record_size;
+        long expanded = 0;
+        char *sol = NULL;
+        int maxvalue = 0, i;
+
+        stats.solver = "bb";
+
+        sorted = malloc((n > 0 ? n : 1) * sizeof(Item));
+        if (!sorted) allocation_error();
+
+        memcpy(sorted, items, n * sizeof(Item));
+        qsort(sorted, n, sizeof(Item), item_density_comp);
+
+        f.open = 0;
+        f.path_len = (n + 7) / 8;
+        record_size = sizeof(NodeRecord) + f.path_len;
+        f.record = malloc(record_size);
+        path = malloc(f.path_len > 0 ? f.path_len : 1);
+        if (!f.record || !path) allocation_error();
+
+        NodeHeap_init(&f.heap, max_bytes ? 0 : n);
+        if (max_bytes) {
+                f.epq = empqueue_init(record_size, max_bytes / 2 /
+                                (sizeof(double) + record_size), NULL);
+                dt = dominance_init(n, max_bytes / 2 /
+                                sizeof(DominanceEntry));
+        } else {
+                f.epq = NULL;
+                dt = dominance_init(n, 0);
+        }
+
+        v = node_init(NULL, 0, 0, 0);
+        v->bound = bound(n, K, sorted, v);
+        frontier_push(&f, v);
+
+        /* While priority queue is not empty ... */
+        while ((v = frontier_pop(&f)) != NULL) {
+
+                DEBUG_PRINT("maxvalue: %d\t v->bound: %f", maxvalue, v->bound);
 
-                        u->bound = bound(n, K, items, u);
+                if ((int) (v->bound + BOUND_TOLERANCE) <= maxvalue ||
+                    v->level == n - 1) {
+                        stats.pruned_bound++;
+                        node_release(v);
+                        continue;
+                }
+                if (v->level >= 0 && !dominance_is_current(dt, v->level,
+                    v->weight, v->value)) {
+                        stats.dropped_dominated++;
+                        node_release(v);
+                        continue;
+                }
 
-                        if (u->bound > maxvalue)
-                                pqueue_enqueue(pq, (void *) u);
-                        else free(u);
+                if (max_nodes && ++expanded > max_nodes) {
+                        node_release(v);
+                        break;
+                }
 
-                        /* Set u to be child that does not include next item */
-                        u = malloc(sizeof(Node));
-                        if (!u) allocation_error();
+                stats.expanded++;
+                item = &sorted[v->level + 1];
 
-                        u->level = v->level + 1;
-                        u->weight = v->weight;
-                        u->value = v->value;
+                /*
+                 * Set u to be child that includes next item.  The weights
+                 * are compared against what is left of K, as their sum may
+                 * not fit in an int.
+                 */
+                if (item->weight <= K - v->weight) {
+                        u = node_init(v, 1, v->value + item->value,
+                                        v->weight + item->weight);
+
+                        if (u->value > maxvalue) {
+                                maxvalue = u->value;
+                                node_release(best);
+                                best = u;
+                                best->refs++;
+                        }
 
-                        u->bound = bound(n, K, items, u);
+                        enqueue_child(&f, dt, n, K, sorted, u, maxvalue);
+                }
 
-                        if (u->bound > maxvalue)
-                                pqueue_enqueue(pq, (void *) u);
-                        else free(u);
+                /* Set u to be child that does not include next item */
+                u = node_init(v, 0, v->value, v->weight);
+                enqueue_child(&f, dt, n, K, sorted, u, maxvalue);
 
-                        free(v);
+                node_release(v);
+        }
 
+        /* Construct solution from the path to the best node. */
+        if (v == NULL) {
+                node_get_path(best, path, f.path_len);
+                for (i = 0; i < n; i++) {
+                        items[sorted[i].id].isTaken =
+                                (path[i / 8] >> (i % 8)) & 1;
                 }
+                sol = knapsack_solution_string(maxvalue, 1, n, items);
         }
 
-        pqueue_free(pq);
+        /* Release the nodes left open if the search gave up. */
+        while ((v = frontier_pop(&f)) != NULL) {
+                node_release(v);
+        }
+
+        DEBUG_PRINT("Solution: %d\n expanded: %ld\n enqueued: %ld\n "
+                        "pruned by bound: %ld\n pruned as dominated: %ld\n "
+                        "dropped as dominated: %ld\n", maxvalue,
+                        stats.expanded, stats.enqueued,
+                        stats.pruned_bound, stats.pruned_dominated,
+                        stats.dropped_dominated);
+
+        if (f.epq) {
+                stats.spill_runs = f.epq->nSpills;
+                stats.spill_records = f.epq->nSpilled;
+                stats.spill_bytes = f.epq->bytesWritten;
+                DEBUG_PRINT("Nodes spilled to disk: %lu\n",
+                                (unsigned long) f.epq->nSpilled);
+        }
+
+        node_release(best);
+        dominance_free(dt);
+        NodeHeap_free(&f.heap);
+        empqueue_free(f.epq);
+        free(f.record);
+        free(path);
+        free(sorted);
 
-        sprintf(sol, "%d\n", maxvalue);
         return sol;
 }
 
@@ -300,6 +600,8 @@ bound(int n, int K, Item *items, Node *x) {
         double ret;
         int j, total_weight;
 
+        stats.bound_evaluations++;
+
         /* If weight of item exceeds capacity of knapsack, it cannot be 
          * part of any feasible solution as so its value is 0. */ 
         if (x->weight > K) return 0;
@@ -309,7 +611,7 @@ bound(int n, int K, Item *items, Node *x) {
         j = x->level + 1;
         total_weight = x->weight;
 
-        while (j < n && (total_weight + items[j].value) <= K) {
+        while (j < n && items[j].weight <= K - total_weight) {
                 total_weight += items[j].weight;
                 ret += items[j].value;
                 j++;
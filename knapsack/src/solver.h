@@ -1,9 +1,20 @@
 #ifndef SOLVER_H
 #define SOLVER_H
 
+#include <stddef.h>
+
 #include "item.h"
 
 char *
 solve_knapsack_instance(int, int, Item *);
 
+char *
+solve_knapsack_instance_bb(int, int, Item *);
+
+char *
+solve_knapsack_instance_bb_spill(int, int, Item *, size_t);
+
+char *
+knapsack_solution_string(int, int, int, Item *);
+
 #endif
@@ -0,0 +1,123 @@
+/*
+ * Module implementing counters describing a run of the knapsack solver.
+ * Counters are plain integers incremented inline by the solvers, so they are
+ * cheap enough to be kept in every build; only dynamic programming cells,
+ * which may be counted from several threads, are added atomically (once per
+ * row rather than per cell).
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "stats.h"
+
+/*
+ * Counters describing the current run.
+ */
+Stats stats;
+
+static const char *phase_names[N_PHASES] = {"parse", "solve", "output"};
+
+/**
+ * Returns the current value of a monotonic clock, in seconds.
+ */
+double
+stats_now(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Starts counting hardware events in each phase.  Events which cannot be
+ * counted are reported as null.
+ */
+void
+stats_perf_open(void) {
+        perf_open();
+        stats.perf = 1;
+}
+
+void
+stats_phase_begin(Phase p) {
+        if (stats.perf) perf_read(&stats.phase_perf_start[p]);
+        stats.phase_start[p] = stats_now();
+}
+
+void
+stats_phase_end(Phase p) {
+
+        PerfCounts end;
+
+        stats.phase_time[p] += stats_now() - stats.phase_start[p];
+
+        if (stats.perf) {
+                perf_read(&end);
+                perf_accumulate(&stats.phase_perf[p],
+                                &stats.phase_perf_start[p], &end);
+        }
+}
+
+/**
+ * Adds the given number of cells to the count of dynamic programming cells
+ * updated.  Safe to call from several threads.
+ */
+void
+stats_add_dp_cells(long long cells) {
+        __atomic_fetch_add(&stats.dp_cells, cells, __ATOMIC_RELAXED);
+}
+
+/**
+ * Writes the counters of the current run as a single JSON object.
+ */
+void
+stats_print_json(FILE *out) {
+
+        struct rusage usage;
+        double solve = stats.phase_time[PHASE_SOLVE];
+        int i;
+
+        getrusage(RUSAGE_SELF, &usage);
+
+        fprintf(out, "{\"solver\": \"%s\", \"value\": %d, \"optimal\": %d, ",
+                        stats.solver ? stats.solver : "none", stats.value,
+                        stats.optimal);
+
+        fprintf(out, "\"nodes\": {\"expanded\": %ld, \"enqueued\": %ld, "
+                        "\"pruned_bound\": %ld, \"pruned_dominated\": %ld, "
+                        "\"dropped_dominated\": %ld, \"peak_open\": %ld}, ",
+                        stats.expanded, stats.enqueued, stats.pruned_bound,
+                        stats.pruned_dominated, stats.dropped_dominated,
+                        stats.peak_open);
+
+        fprintf(out, "\"spill\": {\"runs\": %ld, \"records\": %ld, "
+                        "\"bytes_written\": %lld}, ", stats.spill_runs,
+                        stats.spill_records, stats.spill_bytes);
+
+        fprintf(out, "\"bound_evaluations\": %ld, \"dp_cells\": %lld, "
+                        "\"dp_cells_per_second\": %.0f, ",
+                        stats.bound_evaluations, stats.dp_cells,
+                        solve > 0 ? stats.dp_cells / solve : 0);
+
+        fprintf(out, "\"phases\": {");
+        for (i = 0; i < N_PHASES; i++) {
+                fprintf(out, "%s\"%s\": %.6f", i ? ", " : "", phase_names[i],
+                                stats.phase_time[i]);
+        }
+
+        fprintf(out, "}, ");
+
+        if (stats.perf) {
+                fprintf(out, "\"perf\": {");
+                for (i = 0; i < N_PHASES; i++) {
+                        fprintf(out, "%s\"%s\": ", i ? ", " : "",
+                                        phase_names[i]);
+                        perf_print_json(out, &stats.phase_perf[i]);
+                }
+                fprintf(out, "}, ");
+        }
+
+        /* ru_maxrss is reported in kilobytes on Linux. */
+        fprintf(out, "\"peak_rss_kb\": %ld}\n", usage.ru_maxrss);
+}
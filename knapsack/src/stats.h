@@ -0,0 +1,85 @@
+/*
+ * Module defining counters describing a run of the knapsack solver, reported
+ * as JSON with --stats.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+#include "perf.h"
+
+/*
+ * Phases of a run which are timed.
+ */
+typedef enum {
+        PHASE_PARSE,    /* Reading the input file. */
+        PHASE_SOLVE,    /* Solving the instance. */
+        PHASE_OUTPUT,   /* Writing the solution. */
+        N_PHASES
+} Phase;
+
+typedef struct {
+        /** Name of the solver which ran. */
+        const char *solver;
+
+        /** Value of the solution found and whether it is optimal. */
+        int value;
+        int optimal;
+
+        /** Branch and bound counters. */
+        long expanded;          /* Nodes branched on. */
+        long enqueued;          /* Nodes added to the priority queue. */
+        long pruned_bound;      /* Nodes whose bound could not improve on
+                                 * the best solution found. */
+        long pruned_dominated;  /* Nodes discarded before being enqueued as
+                                 * dominated by a node at the same level. */
+        long dropped_dominated; /* Nodes skipped when dequeued as dominated
+                                 * by a node enqueued after them. */
+        long peak_open;         /* Largest number of open nodes. */
+        long bound_evaluations; /* Calls to bound(). */
+
+        /** External memory queue counters, with --spill. */
+        long spill_runs;        /* Runs written from the queue's head. */
+        long spill_records;     /* Nodes written in those runs. */
+        long long spill_bytes;  /* Bytes written by spills and merges. */
+
+        /** Dynamic programming cells (capacities or values) updated. */
+        long long dp_cells;
+
+        /** Wall time spent in each phase, in seconds. */
+        double phase_time[N_PHASES];
+
+        /** Start of each phase, in seconds. */
+        double phase_start[N_PHASES];
+
+        /** Flag indicating hardware counters are read around each phase. */
+        int perf;
+
+        /** Hardware events counted in each phase, and at its start. */
+        PerfCounts phase_perf[N_PHASES];
+        PerfCounts phase_perf_start[N_PHASES];
+} Stats;
+
+extern Stats stats;
+
+double
+stats_now(void);
+
+void
+stats_perf_open(void);
+
+void
+stats_phase_begin(Phase);
+
+void
+stats_phase_end(Phase);
+
+void
+stats_add_dp_cells(long long);
+
+void
+stats_print_json(FILE *);
+
+#endif
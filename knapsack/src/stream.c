@@ -0,0 +1,343 @@
+/*
+ * Module implementing a streaming dynamic programming solver for the
+ * knapsack problem.  A reader thread parses items from the input file and
+ * hands them through a bounded queue to the worker, which applies each item
+ * to a single rolling row of the sub-solution matrix as it arrives.  The
+ * time to solve an instance thus approaches max(parse, compute) rather than
+ * their sum.  The same row update also solves items already in memory.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "item.h"
+#include "parser.h"
+#include "partition.h"
+#include "solver.h"
+#include "stats.h"
+#include "stream.h"
+#include "utils.h"
+
+typedef struct {
+        /** Circular buffer of items waiting to be processed. */
+        Item *items;
+
+        /** Index of the oldest item in the buffer. */
+        int head;
+
+        /** Number of items currently in the buffer. */
+        int count;
+
+        /** Set by the reader once no more items will be enqueued. */
+        int closed;
+
+        pthread_mutex_t lock;
+        pthread_cond_t not_empty;
+        pthread_cond_t not_full;
+} ItemQueue;
+
+typedef struct {
+        /** Handle to the input file, positioned after the header line. */
+        FILE *in;
+
+        /** Number of items the reader is expected to parse. */
+        int n;
+
+        /** Array into which the parsed items are stored. */
+        Item *items;
+
+        /** Queue through which parsed items are handed to the worker. */
+        ItemQueue *q;
+} Reader;
+
+static void
+item_queue_init(ItemQueue *q) {
+
+        q->items = malloc(STREAM_QUEUE_SIZE * sizeof(Item));
+        if (!q->items) ALLOCATION_ERROR();
+
+        q->head = 0;
+        q->count = 0;
+        q->closed = 0;
+
+        pthread_mutex_init(&q->lock, NULL);
+        pthread_cond_init(&q->not_empty, NULL);
+        pthread_cond_init(&q->not_full, NULL);
+}
+
+static void
+item_queue_free(ItemQueue *q) {
+        pthread_mutex_destroy(&q->lock);
+        pthread_cond_destroy(&q->not_empty);
+        pthread_cond_destroy(&q->not_full);
+        free(q->items);
+}
+
+/**
+ * Appends the given items to the queue, blocking while the queue is full.
+ */
+static void
+item_queue_push(ItemQueue *q, Item *items, int count) {
+
+        int i = 0, tail;
+
+        pthread_mutex_lock(&q->lock);
+        while (i < count) {
+                while (q->count == STREAM_QUEUE_SIZE)
+                        pthread_cond_wait(&q->not_full, &q->lock);
+
+                while (i < count && q->count < STREAM_QUEUE_SIZE) {
+                        tail = (q->head + q->count) % STREAM_QUEUE_SIZE;
+                        q->items[tail] = items[i++];
+                        q->count++;
+                }
+                pthread_cond_signal(&q->not_empty);
+        }
+        pthread_mutex_unlock(&q->lock);
+}
+
+/**
+ * Marks the queue as closed, waking the worker if it is waiting on items.
+ */
+static void
+item_queue_close(ItemQueue *q) {
+        pthread_mutex_lock(&q->lock);
+        q->closed = 1;
+        pthread_cond_signal(&q->not_empty);
+        pthread_mutex_unlock(&q->lock);
+}
+
+/**
+ * Removes up to max items from the queue, blocking while the queue is empty.
+ * @return
+ *      The number of items removed.  0 once the queue is closed and drained.
+ */
+static int
+item_queue_pop(ItemQueue *q, Item *items, int max) {
+
+        int count = 0;
+
+        pthread_mutex_lock(&q->lock);
+        while (q->count == 0 && !q->closed)
+                pthread_cond_wait(&q->not_empty, &q->lock);
+
+        while (count < max && q->count > 0) {
+                items[count++] = q->items[q->head];
+                q->head = (q->head + 1) % STREAM_QUEUE_SIZE;
+                q->count--;
+        }
+        pthread_cond_signal(&q->not_full);
+        pthread_mutex_unlock(&q->lock);
+
+        return count;
+}
+
+/**
+ * Entry point of the reader thread.  Parses items from the input file in
+ * batches and hands them to the worker.
+ */
+static void *
+reader_run(void *x) {
+
+        Reader *r = (Reader *) x;
+        Item batch[STREAM_BATCH_SIZE];
+        int i = 0, count = 0;
+
+        while (i < r->n) {
+                if (!parser_read_item(r->in, i, &batch[count])) {
+                        fprintf(stderr, "Less items were given than was "
+                                        "specified on first line of input.\n");
+                        exit(1);
+                }
+                r->items[i++] = batch[count++];
+
+                if (count == STREAM_BATCH_SIZE || i == r->n) {
+                        item_queue_push(r->q, batch, count);
+                        count = 0;
+                }
+        }
+
+        item_queue_close(r->q);
+        return NULL;
+}
+
+/**
+ * Applies the given item to the row A of capacities 0..K, setting bit w of
+ * taken_row where the item improved on capacity w.
+ */
+static void
+dp_apply(int *A, unsigned char *taken_row, Item item, int K) {
+
+        int w, candidate;
+
+        if (item.weight <= K) stats.dp_cells += K - item.weight + 1;
+        for (w = K; w >= item.weight; w--) {
+                candidate = A[w - item.weight] + item.value;
+                if (candidate > A[w]) {
+                        A[w] = candidate;
+                        taken_row[w >> 3] |= 1 << (w & 7);
+                }
+        }
+}
+
+/**
+ * Sets the isTaken attribute of the items by walking the recorded
+ * decisions backwards from capacity K.
+ */
+static void
+dp_backtrack(unsigned char *taken, size_t stride, int n, int K,
+    Item *items) {
+
+        unsigned char *taken_row;
+        int i, w = K;
+
+        for (i = n - 1; i >= 0; i--) {
+                taken_row = taken + (size_t) i * stride;
+                if (taken_row[w >> 3] & (1 << (w & 7))) {
+                        items[i].isTaken = 1;
+                        w -= items[i].weight;
+                }
+        }
+}
+
+/**
+ * Returns the bytes of the decision bit matrix of an instance with n items
+ * and capacity K.
+ */
+size_t
+dp_matrix_bytes(int n, int K) {
+        return (size_t) (n > 0 ? n : 1) * ((size_t) K / 8 + 1);
+}
+
+/**
+ * Solve the instance of the knapsack problem whose items are read from the
+ * given input file while they are being solved.
+ * Only a single row of the sub-solution matrix is kept.  Whether or not
+ * item i improved on capacity w is recorded in a bit matrix so that the
+ * solution can be reconstructed once all items have been applied.
+ * @param FILE *in
+ *      Handle to the input file, positioned after the header line.
+ * @param int n
+ *      The number of items to be considered.
+ * @param int K
+ *      The capacity of the knapsack.
+ * @param Item **items
+ *      Pointer to array of Items.  Function will initialize needed heap
+ *      memory and store the items read from the input file.
+ *
+ * @return
+ *      String encoding solution.
+ */
+char *
+solve_knapsack_stream(FILE *in, int n, int K, Item **items) {
+
+        ItemQueue q;
+        Reader r;
+        pthread_t reader;
+        Item batch[STREAM_BATCH_SIZE];
+        unsigned char *taken;
+        size_t stride;
+        int *A, i = 0, j, count, value;
+
+        assert(in != NULL);
+        assert(items != NULL);
+
+        stats.solver = "stream";
+
+        *items = malloc((n > 0 ? n : 1) * sizeof(Item));
+        if (!*items) ALLOCATION_ERROR();
+
+        /* A[w] holds the best value achievable with capacity w using the
+         * items applied so far. */
+        A = calloc((size_t) K + 1, sizeof(int));
+        if (!A) ALLOCATION_ERROR();
+
+        stride = (size_t) K / 8 + 1;
+        taken = calloc(dp_matrix_bytes(n, K), 1);
+        if (!taken) ALLOCATION_ERROR();
+
+        item_queue_init(&q);
+        r.in = in;
+        r.n = n;
+        r.items = *items;
+        r.q = &q;
+
+        if (pthread_create(&reader, NULL, reader_run, &r) != 0) {
+                fprintf(stderr, "Failed to create reader thread.\n");
+                exit(1);
+        }
+
+        while ((count = item_queue_pop(&q, batch, STREAM_BATCH_SIZE)) > 0) {
+                for (j = 0; j < count; j++, i++) {
+                        dp_apply(A, taken + (size_t) i * stride, batch[j],
+                                        K);
+                }
+        }
+
+        pthread_join(reader, NULL);
+        item_queue_free(&q);
+
+        dp_backtrack(taken, stride, n, K, *items);
+
+        value = A[K];
+        DEBUG_PRINT("Solution: %d\n", value);
+
+        free(taken);
+        free(A);
+
+        return knapsack_solution_string(value, 1, n, *items);
+}
+
+/**
+ * Solve instance of knapsack problem by dynamic programming on a single
+ * thread, keeping a single row of the sub-solution matrix and a bit matrix
+ * of decisions as the streaming solver does.  Each cell is computed once,
+ * whereas the item-partitioned solver computes the profiles of its groups
+ * again at every level of its recursion.  If the bit matrix would exceed
+ * DP_MATRIX_MAX_BYTES the item-partitioned solver is used instead, as it
+ * needs only O(K) memory per level.
+ * @param int n
+ *      The number of items to be considered.
+ * @param int K
+ *      The capacity of the knapsack.
+ * @param Item *items
+ *      Array of Item structs corresponding to the items to be placed in the
+ *      knapsack.
+ *
+ * @return
+ *      String encoding solution.
+ */
+char *
+solve_knapsack_dp(int n, int K, Item *items) {
+
+        unsigned char *taken;
+        size_t stride;
+        int *A, i, value;
+
+        if (dp_matrix_bytes(n, K) > DP_MATRIX_MAX_BYTES)
+                return solve_knapsack_partition(n, K, items, 1);
+
+        stats.solver = "dp";
+
+        A = calloc((size_t) K + 1, sizeof(int));
+        taken = calloc(dp_matrix_bytes(n, K), 1);
+        if (!A || !taken) ALLOCATION_ERROR();
+
+        stride = (size_t) K / 8 + 1;
+        for (i = 0; i < n; i++) {
+                dp_apply(A, taken + (size_t) i * stride, items[i], K);
+        }
+
+        dp_backtrack(taken, stride, n, K, items);
+
+        value = A[K];
+        DEBUG_PRINT("Solution: %d\n", value);
+
+        free(taken);
+        free(A);
+
+        return knapsack_solution_string(value, 1, n, items);
+}
@@ -0,0 +1,43 @@
+/*
+ * Module defining a streaming dynamic programming solver for the knapsack
+ * problem which overlaps reading the input file with computation, and its
+ * single threaded counterpart for items already in memory.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "item.h"
+
+/**
+ * Constant defining the number of items which can be held in the queue
+ * between the reader thread and the dynamic programming worker.
+ */
+#define STREAM_QUEUE_SIZE 4096
+
+/**
+ * Constant defining the number of items the reader thread parses before
+ * handing them to the queue (and the worker takes from the queue at once).
+ */
+#define STREAM_BATCH_SIZE 64
+
+/**
+ * Constant defining the largest decision bit matrix (in bytes) the single
+ * threaded dynamic programming solver allocates before leaving the instance
+ * to the item-partitioned solver.
+ */
+#define DP_MATRIX_MAX_BYTES (2UL * 1024 * 1024 * 1024)
+
+size_t
+dp_matrix_bytes(int, int);
+
+char *
+solve_knapsack_stream(FILE *, int, int, Item **);
+
+char *
+solve_knapsack_dp(int, int, Item *);
+
+#endif
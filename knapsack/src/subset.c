@@ -0,0 +1,171 @@
+/*
+ * Module implementing a word-parallel solver for instances of the knapsack
+ * problem in which every item's value equals its weight.  Maximizing value
+ * is then the same as finding the largest reachable subset sum no greater
+ * than K.
+ *
+ * The set of reachable sums is kept as a bitset of K + 1 bits, and applying
+ * an item of weight w is the shift-OR R |= R << w, which advances 64 sums
+ * per machine word.  The subset achieving the best sum is recovered by
+ * splitting the items in half, finding a pair of sums reachable by each
+ * half which add to the target and recursing into each half with its sum,
+ * so no more than O(K / 8) bytes per level of the recursion are needed.
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "item.h"
+#include "solver.h"
+#include "stats.h"
+#include "subset.h"
+#include "utils.h"
+
+#define WORD_BITS 64
+
+#define BIT_IS_SET(R, s) (((R)[(s) / WORD_BITS] >> ((s) % WORD_BITS)) & 1)
+
+/**
+ * Returns 1 if every item's value equals its weight, 0 otherwise.
+ * @param int n
+ *      The number of items in the instance.
+ * @param Item *items
+ *      Array of Item structs of the instance.
+ */
+int
+knapsack_is_subset_sum(int n, Item *items) {
+
+        int i;
+
+        for (i = 0; i < n; i++) {
+                if (items[i].value != items[i].weight || items[i].weight < 0)
+                        return 0;
+        }
+        return 1;
+}
+
+/**
+ * Computes the bitset of sums 0..c reachable by subsets of items [lo, hi).
+ * @param uint64_t *R
+ *      Array of c / WORD_BITS + 1 words into which the bitset is stored.
+ */
+static void
+reachable_sums(Item *items, int lo, int hi, int c, uint64_t *R) {
+
+        int nwords = c / WORD_BITS + 1, i, j, q, r;
+
+        memset(R, 0, nwords * sizeof(uint64_t));
+        R[0] = 1;
+
+        for (i = lo; i < hi; i++) {
+                if (items[i].weight > c || items[i].weight == 0) continue;
+
+                stats.dp_cells += c - items[i].weight + 1;
+                q = items[i].weight / WORD_BITS;
+                r = items[i].weight % WORD_BITS;
+
+                /* 
+                 * Shift-OR from the highest word down, so every word read
+                 * still holds the sums reachable before this item.
+                 */
+                if (r == 0) {
+                        for (j = nwords - 1; j >= q; j--)
+                                R[j] |= R[j - q];
+                } else {
+                        for (j = nwords - 1; j > q; j--)
+                                R[j] |= (R[j - q] << r) |
+                                        (R[j - q - 1] >> (WORD_BITS - r));
+                        R[q] |= R[0] << r;
+                }
+        }
+
+        /* Clear sums beyond c held in the last word. */
+        if ((c + 1) % WORD_BITS)
+                R[nwords - 1] &= ((uint64_t) 1 << ((c + 1) % WORD_BITS)) - 1;
+}
+
+/**
+ * Sets the isTaken attribute of items [lo, hi) such that the weights of the
+ * items taken add to exactly target, which must be reachable.
+ */
+static void
+reconstruct(Item *items, int lo, int hi, int target) {
+
+        uint64_t *A, *B;
+        int mid, a;
+
+        if (hi - lo == 1) {
+                items[lo].isTaken = target > 0;
+                assert(target == 0 || target == items[lo].weight);
+                return;
+        }
+
+        mid = lo + (hi - lo) / 2;
+        A = malloc((target / WORD_BITS + 1) * sizeof(uint64_t));
+        B = malloc((target / WORD_BITS + 1) * sizeof(uint64_t));
+        if (!A || !B) ALLOCATION_ERROR();
+
+        reachable_sums(items, lo, mid, target, A);
+        reachable_sums(items, mid, hi, target, B);
+
+        for (a = 0; a <= target; a++) {
+                if (BIT_IS_SET(A, a) && BIT_IS_SET(B, target - a)) break;
+        }
+        assert(a <= target);
+
+        free(A);
+        free(B);
+
+        reconstruct(items, lo, mid, a);
+        reconstruct(items, mid, hi, target - a);
+}
+
+/**
+ * Solve instance of knapsack problem in which every item's value equals its
+ * weight.
+ * @param int n
+ *      The number of items to be considered.
+ * @param int K
+ *      The capacity of the knapsack.
+ * @param Item *items
+ *      Array of Item structs corresponding to the items to be placed in the
+ *      knapsack. 
+ *
+ * @return
+ *      String encoding solution.
+ */
+char *
+solve_knapsack_subset_sum(int n, int K, Item *items) {
+
+        uint64_t *R;
+        int j, best = 0;
+
+        assert(knapsack_is_subset_sum(n, items));
+
+        stats.solver = "subset";
+
+        R = malloc((K / WORD_BITS + 1) * sizeof(uint64_t));
+        if (!R) ALLOCATION_ERROR();
+
+        reachable_sums(items, 0, n, K, R);
+
+        /* Find the largest reachable sum. */
+        for (j = K / WORD_BITS; j >= 0; j--) {
+                if (R[j]) {
+                        best = j * WORD_BITS + (WORD_BITS - 1) -
+                                __builtin_clzll(R[j]);
+                        break;
+                }
+        }
+
+        free(R);
+
+        if (n > 0) reconstruct(items, 0, n, best);
+
+        DEBUG_PRINT("Solution: %d\n", best);
+
+        return knapsack_solution_string(best, 1, n, items);
+}
@@ -0,0 +1,17 @@
+/*
+ * Module defining a word-parallel solver for instances of the knapsack
+ * problem in which every item's value equals its weight (subset sum).
+ * Marko Tomislav Babic - mbabic@ualberta.ca
+ */
+#ifndef SUBSET_H
+#define SUBSET_H
+
+#include "item.h"
+
+int
+knapsack_is_subset_sum(int, Item *);
+
+char *
+solve_knapsack_subset_sum(int, int, Item *);
+
+#endif
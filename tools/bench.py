@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Benchmark harness for the knapsack and coloring solvers.
+#
+# Runs a solver over every instance in a data directory, repeating each run,
+# and records the median wall time, peak RSS, objective value and (for
+# coloring) the number of colors used.  The results are written to a JSON
+# report and, if a baseline report exists, compared against it.  Knapsack
+# solutions are checked to fit the capacity and to be worth the objective
+# reported.  The exit status is 1 if any instance regressed or got an
+# infeasible solution, so the harness can gate a build.
+#
+# Marko Tomislav Babic - mbabic@ualberta.ca
+
+import argparse
+import json
+import os
+import platform
+import re
+import signal
+import statistics
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+
+def instance_key(name):
+    """Sorts instances by size then by name, e.g. ks_4_0 before ks_19_0."""
+    return [int(t) if t.isdigit() else t for t in re.split(r'(\d+)', name)]
+
+
+def run_once(cmd, timeout):
+    """Runs cmd once.
+
+    Returns a tuple (status, wall seconds, peak RSS in KB, stdout), where
+    status is 'ok', 'timeout' or 'error'.  The child is reaped with wait4 so
+    that its peak RSS is its own rather than the largest of all children.
+    Linux carries the peak RSS of this process into the child across exec,
+    so no run reports less than rss_floor().
+    """
+    with tempfile.TemporaryFile() as out:
+        start = time.monotonic()
+        proc = subprocess.Popen(cmd, stdout=out, stderr=subprocess.DEVNULL)
+        killed = []
+
+        def kill():
+            killed.append(True)
+            os.kill(proc.pid, signal.SIGKILL)
+
+        timer = threading.Timer(timeout, kill)
+        timer.start()
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall = time.monotonic() - start
+        timer.cancel()
+        proc.returncode = status
+
+        out.seek(0)
+        stdout = out.read().decode(errors='replace')
+
+    if killed:
+        return 'timeout', wall, usage.ru_maxrss, stdout
+    if status != 0:
+        return 'error', wall, usage.ru_maxrss, stdout
+    return 'ok', wall, usage.ru_maxrss, stdout
+
+
+def rss_floor():
+    """Returns the peak RSS in KB reported for a process doing nothing."""
+    return run_once(['true'], 10)[2]
+
+
+def parse_solution(kind, stdout):
+    """Returns (objective, colors) parsed from a solution string.
+
+    Both solvers write the objective and an optimality flag on the first
+    line and one entry per item or node on the second.  Either is None if
+    the solver wrote no solution.
+    """
+    lines = stdout.split('\n')
+    first = lines[0].split()
+    if not first:
+        return None, None
+
+    objective = int(first[0])
+    colors = None
+    if kind == 'coloring' and len(lines) > 1 and lines[1].split():
+        colors = len(set(lines[1].split()))
+
+    return objective, colors
+
+
+def knapsack_is_feasible(path, stdout):
+    """Returns True if a knapsack solution takes items fitting the capacity
+    whose values sum to the objective reported."""
+    with open(path) as f:
+        lines = f.read().split('\n')
+    n, K = map(int, lines[0].split())
+    items = [tuple(map(int, line.split())) for line in lines[1:n + 1]]
+
+    out = stdout.split('\n')
+    taken = [int(t) for t in out[1].split()] if len(out) > 1 else []
+    if len(taken) != n:
+        return False
+
+    value = sum(v for (v, w), x in zip(items, taken) if x)
+    weight = sum(w for (v, w), x in zip(items, taken) if x)
+    return weight <= K and value == int(out[0].split()[0])
+
+
+def run_instance(args, path):
+    """Runs the solver on one instance args.repeats times."""
+    cmd = [args.solver] + args.solver_args + [path]
+    walls, rss = [], 0
+    result = {'status': 'ok', 'objective': None}
+    if args.kind == 'coloring':
+        result['colors'] = None
+
+    for _ in range(args.repeats):
+        status, wall, peak, stdout = run_once(cmd, args.timeout)
+        walls.append(wall)
+        rss = max(rss, peak)
+        if status != 'ok':
+            result['status'] = status
+            break
+
+        objective, colors = parse_solution(args.kind, stdout)
+        result['objective'] = objective
+        if (args.kind == 'knapsack' and objective is not None and
+                not knapsack_is_feasible(path, stdout)):
+            result['status'] = 'infeasible'
+            break
+        if args.kind == 'coloring':
+            result['colors'] = colors
+
+    result['wall'] = walls
+    result['wall_median'] = statistics.median(walls)
+    result['peak_rss_kb'] = rss
+
+    return result
+
+
+def worse(kind, objective, base):
+    """Returns True if objective is worse than base for the given solver."""
+    if base is None:
+        return False
+    if objective is None:
+        return True
+    # Knapsack maximizes value, coloring minimizes colors.
+    return objective < base if kind == 'knapsack' else objective > base
+
+
+def compare(args, report, baseline):
+    """Prints a comparison of report against baseline.
+
+    An instance regresses if it no longer solves, if its objective got
+    worse, or if its median wall time grew by more than the threshold and by
+    more than the noise floor.  Returns the number of regressions.
+    """
+    regressions = 0
+    print('\n%-14s %10s %10s %8s %10s %10s  %s' % ('instance', 'base (s)',
+          'now (s)', 'ratio', 'base obj', 'now obj', ''))
+
+    for name in sorted(report['instances'], key=instance_key):
+        now = report['instances'][name]
+        base = baseline['instances'].get(name)
+        if base is None:
+            print('%-14s %10s %10.4f %8s %10s %10s  new' % (name, '-',
+                  now['wall_median'], '-', '-', now['objective']))
+            continue
+
+        notes = []
+        ratio = now['wall_median'] / max(base['wall_median'], 1e-9)
+        if now['status'] != 'ok' and base['status'] == 'ok':
+            notes.append(now['status'])
+        if worse(args.kind, now['objective'], base['objective']):
+            notes.append('objective')
+        if (ratio > 1 + args.threshold and
+                now['wall_median'] - base['wall_median'] > args.noise):
+            notes.append('slower')
+        elif (ratio < 1 - args.threshold and
+                base['wall_median'] - now['wall_median'] > args.noise):
+            notes.append('faster')
+
+        if set(notes) - {'faster'}:
+            regressions += 1
+            notes.insert(0, 'REGRESSION')
+
+        print('%-14s %10.4f %10.4f %8.2f %10s %10s  %s' % (name,
+              base['wall_median'], now['wall_median'], ratio,
+              base['objective'], now['objective'], ' '.join(notes)))
+
+    print('\n%d regression(s) against %s' % (regressions, args.baseline))
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Benchmark a solver over a directory of instances.")
+    parser.add_argument('kind', choices=['knapsack', 'coloring'])
+    parser.add_argument('solver', help='path to the solver binary')
+    parser.add_argument('data', help='directory of instances')
+    parser.add_argument('--repeats', type=int, default=3)
+    parser.add_argument('--timeout', type=float, default=300,
+                        help='seconds allowed per run')
+    parser.add_argument('--report', default='bench.json',
+                        help='path of the report written')
+    parser.add_argument('--baseline', help='report to compare against')
+    parser.add_argument('--save-baseline', action='store_true',
+                        help='write the report to the baseline path too')
+    parser.add_argument('--threshold', type=float, default=0.10,
+                        help='fraction of slow down counted as a regression')
+    parser.add_argument('--noise', type=float, default=0.02,
+                        help='seconds of slow down ignored as noise')
+    parser.epilog = 'Arguments after -- are passed to the solver.'
+
+    # Split off the solver's arguments before argparse sees them.
+    argv = sys.argv[1:]
+    split = argv.index('--') if '--' in argv else len(argv)
+    args = parser.parse_args(argv[:split])
+    args.solver_args = argv[split + 1:]
+
+    report = {
+        'kind': args.kind,
+        'solver': args.solver,
+        'solver_args': args.solver_args,
+        'repeats': args.repeats,
+        'host': platform.node(),
+        'machine': platform.machine(),
+        'date': time.strftime('%Y-%m-%dT%H:%M:%S'),
+        'rss_floor_kb': rss_floor(),
+        'instances': {},
+    }
+
+    names = sorted(os.listdir(args.data), key=instance_key)
+    for name in names:
+        r = run_instance(args, os.path.join(args.data, name))
+        report['instances'][name] = r
+        line = '%-14s %-7s %10.4f s %9d KB  objective %s' % (name,
+               r['status'], r['wall_median'], r['peak_rss_kb'],
+               r['objective'])
+        if args.kind == 'coloring':
+            line += '  colors %s' % r['colors']
+        print(line)
+        sys.stdout.flush()
+
+    with open(args.report, 'w') as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+    print('\nReport written to %s' % args.report)
+
+    # A wrong answer fails the run whether or not there is a baseline.
+    infeasible = sorted((name for name, r in report['instances'].items()
+                         if r['status'] == 'infeasible'), key=instance_key)
+    if infeasible:
+        print('Infeasible solutions: %s' % ' '.join(infeasible))
+
+    if args.baseline and args.save_baseline:
+        with open(args.baseline, 'w') as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+        print('Baseline written to %s' % args.baseline)
+        return 1 if infeasible else 0
+
+    if args.baseline and os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        return 1 if compare(args, report, baseline) or infeasible else 0
+
+    return 1 if infeasible else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Generator of synthetic knapsack and graph coloring instances for scaling
+# studies, written in the formats read by the solvers:
+#
+#   knapsack: "n K" followed by one "value weight" line per item.
+#   coloring: "n E" followed by one "u v" line per edge, 0 <= u, v < n.
+#
+# Every generator is driven by a single seeded PRNG, so the same arguments
+# always produce the same instance.
+#
+# Examples:
+#   tools/generate.py knapsack strong -n 1000000 -R 10000 > ks_strong_1e6
+#   tools/generate.py graph gnp -n 100000 -d 20 > gc_gnp_1e5
+#   tools/generate.py graph planted -n 100000 -k 30 -d 40 > gc_planted_1e5
+#
+# Marko Tomislav Babic - mbabic@ualberta.ca
+
+import argparse
+import math
+import random
+import sys
+
+
+def knapsack_items(kind, n, R, rng):
+    """Yields (value, weight) pairs of one of the classic instance types.
+
+    Weights are uniform in [1, R].  Values are
+      uncorrelated:  uniform in [1, R];
+      weak:          uniform in [w - R/10, w + R/10], at least 1;
+      strong:        w + R/10;
+      subset:        w, the instances solved by the bitset solver.
+    """
+    spread = max(1, R // 10)
+    for _ in range(n):
+        w = rng.randint(1, R)
+        if kind == 'uncorrelated':
+            v = rng.randint(1, R)
+        elif kind == 'weak':
+            v = max(1, rng.randint(w - spread, w + spread))
+        elif kind == 'strong':
+            v = w + spread
+        else:
+            v = w
+        yield v, w
+
+
+def write_knapsack(args, rng, out):
+    items = list(knapsack_items(args.type, args.n, args.range, rng))
+    total = sum(w for _, w in items)
+
+    K = args.capacity
+    if K is None:
+        K = max(1, int(total * args.fraction))
+    if K > 2 ** 31 - 1:
+        sys.exit('Capacity %d does not fit in an int; lower -R or -f.' % K)
+
+    out.write('%d %d\n' % (args.n, K))
+    out.writelines('%d %d\n' % item for item in items)
+
+
+def gnp_edges(n, p, rng):
+    """Yields the edges of an Erdos-Renyi G(n, p) graph.
+
+    Skips over the pairs not taken with geometrically distributed jumps
+    (Batagelj and Brandes), so the time is linear in the number of edges
+    rather than quadratic in n.
+    """
+    if p <= 0:
+        return
+    if p >= 1:
+        for u in range(n):
+            for v in range(u):
+                yield v, u
+        return
+
+    log_q = math.log(1 - p)
+    u, v = 1, -1
+    while u < n:
+        v += 1 + int(math.log(1 - rng.random()) / log_q)
+        while v >= u and u < n:
+            v -= u
+            u += 1
+        if u < n:
+            yield v, u
+
+
+def geometric_edges(n, d, rng):
+    """Yields the edges of a random geometric graph.
+
+    Points are uniform in the unit square and joined when closer than the
+    radius giving an expected degree of d.  Points are bucketed into a grid
+    of cells as wide as the radius, so only neighboring cells are searched.
+    """
+    r = math.sqrt(d / (math.pi * max(n - 1, 1)))
+    cells = max(1, int(1 / r))
+    pts = [(rng.random(), rng.random()) for _ in range(n)]
+
+    grid = {}
+    for i, (x, y) in enumerate(pts):
+        key = (min(int(x * cells), cells - 1), min(int(y * cells), cells - 1))
+        grid.setdefault(key, []).append(i)
+
+    r2 = r * r
+    for (cx, cy), members in grid.items():
+        for dx in (-1, 0, 1):
+            for dy in (-1, 0, 1):
+                others = grid.get((cx + dx, cy + dy))
+                if not others:
+                    continue
+                for i in members:
+                    xi, yi = pts[i]
+                    for j in others:
+                        if j <= i:
+                            continue
+                        xj, yj = pts[j]
+                        if (xi - xj) ** 2 + (yi - yj) ** 2 < r2:
+                            yield i, j
+
+
+def powerlaw_edges(n, d, rng):
+    """Yields the edges of a Barabasi-Albert preferential attachment graph.
+
+    Each node attaches to m = d / 2 distinct earlier nodes chosen with
+    probability proportional to their degree, giving a power law degree
+    distribution with mean close to d.
+    """
+    m = max(1, int(round(d / 2.0)))
+    targets = []    # Each node appears once per incident edge.
+
+    for u in range(min(m + 1, n)):
+        for v in range(u):
+            targets.extend((u, v))
+            yield v, u
+
+    for u in range(m + 1, n):
+        chosen = set()
+        while len(chosen) < m:
+            chosen.add(targets[rng.randrange(len(targets))])
+        for v in chosen:
+            targets.extend((u, v))
+            yield v, u
+
+
+def planted_edges(n, k, d, rng, path):
+    """Yields the edges of a graph with a planted k-coloring.
+
+    Nodes get uniformly random colors in [0, k) and n * d / 2 distinct edges
+    are drawn between nodes of different colors, so the graph is k-colorable
+    by construction.  The planted coloring is written to path, if given.
+    """
+    color = [rng.randrange(k) for _ in range(n)]
+    wanted = int(n * d / 2)
+    edges = set()
+    tries = 0
+
+    while len(edges) < wanted and tries < 20 * wanted + 100:
+        tries += 1
+        u, v = rng.randrange(n), rng.randrange(n)
+        if color[u] == color[v]:
+            continue
+        edges.add((min(u, v), max(u, v)))
+
+    if path:
+        with open(path, 'w') as f:
+            f.write(' '.join(map(str, color)) + '\n')
+
+    return sorted(edges)
+
+
+def write_graph(args, rng, out):
+    n, d = args.n, args.degree
+    if args.type == 'gnp':
+        p = args.p if args.p is not None else d / max(n - 1, 1)
+        edges = gnp_edges(n, p, rng)
+    elif args.type == 'geometric':
+        edges = geometric_edges(n, d, rng)
+    elif args.type == 'powerlaw':
+        edges = powerlaw_edges(n, d, rng)
+    else:
+        edges = planted_edges(n, args.k, d, rng, args.planted)
+
+    # The edge count heads the file, so the edges are collected first.
+    edges = list(edges)
+    out.write('%d %d\n' % (n, len(edges)))
+    out.writelines('%d %d\n' % e for e in edges)
+
+
+def main():
+    common = argparse.ArgumentParser(add_help=False)
+    common.add_argument('--seed', type=int, default=1,
+                        help='seed of the PRNG (default 1)')
+    common.add_argument('-o', '--output', help='output file (default stdout)')
+
+    parser = argparse.ArgumentParser(
+        description='Generate synthetic knapsack and coloring instances.')
+    sub = parser.add_subparsers(dest='problem', required=True)
+
+    ks = sub.add_parser('knapsack', parents=[common],
+                        help='knapsack instance')
+    ks.add_argument('type', choices=['uncorrelated', 'weak', 'strong',
+                                     'subset'])
+    ks.add_argument('-n', type=int, required=True, help='number of items')
+    ks.add_argument('-R', '--range', type=int, default=1000,
+                    help='weights are drawn from [1, R] (default 1000)')
+    ks.add_argument('-K', '--capacity', type=int,
+                    help='capacity of the knapsack')
+    ks.add_argument('-f', '--fraction', type=float, default=0.5,
+                    help='capacity as a fraction of the total weight, if '
+                         '-K is not given (default 0.5)')
+
+    gr = sub.add_parser('graph', parents=[common],
+                        help='graph coloring instance')
+    gr.add_argument('type', choices=['gnp', 'geometric', 'powerlaw',
+                                     'planted'])
+    gr.add_argument('-n', type=int, required=True, help='number of nodes')
+    gr.add_argument('-d', '--degree', type=float, default=10,
+                    help='expected average degree (default 10)')
+    gr.add_argument('-p', type=float,
+                    help='edge probability of gnp, overriding -d')
+    gr.add_argument('-k', type=int, default=10,
+                    help='number of planted colors (default 10)')
+    gr.add_argument('--planted', metavar='FILE',
+                    help='file to which the planted coloring is written')
+
+    args = parser.parse_args()
+    rng = random.Random(args.seed)
+    out = open(args.output, 'w') if args.output else sys.stdout
+
+    if args.problem == 'knapsack':
+        write_knapsack(args, rng, out)
+    else:
+        write_graph(args, rng, out)
+
+    if out is not sys.stdout:
+        out.close()
+
+
+if __name__ == '__main__':
+    main()